@@ -0,0 +1,665 @@
+// Decode benchmark and regression check for the asset path. Every image in a directory, plus a few
+// large synthetic PNGs, is decoded from memory with stbi_load_from_memory many times, first on one
+// thread and then on several threads at once. Each case reports the median and p99 latency of a single
+// decode, the throughput in decoded MB/s, the peak RSS while decoding and a checksum of the pixels.
+// Needs no GL context.
+//
+// usage: DecodeBench [--runs N] [--threads 1,2,4] [--dir DIR] [--only SUBSTRING] [--synthetic WxHxC]...
+//                    [--no-synthetic] [--format table|csv|json] [--baseline FILE] [--tolerance PERCENT]
+//   --runs        decodes per thread and case after one untimed warm-up, default 20
+//   --threads     thread counts to run, default 1 and the number of hardware threads
+//   --dir         images to decode, default resources/textures
+//   --only        only cases whose name contains SUBSTRING. Peak RSS is per case on Linux only, elsewhere
+//                 it is the run's so far, so run one image at a time to see what it needs
+//   --synthetic   add a generated PNG of that size, replaces the default 2048x2048x3 and 4096x4096x4
+//   --format      json writes one object per line; save it and pass it to --baseline on a later run
+//   --baseline    compare with an earlier --format json run: a case whose median is more than
+//                 --tolerance percent slower (default 10), or whose checksum differs, is reported and
+//                 makes the program exit with 1
+#include <mapped_file.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <dirent.h>
+#include <sys/resource.h>
+#endif
+
+struct Source
+{
+    std::string Name;
+    std::vector<unsigned char> Bytes; // the encoded file
+};
+
+struct Result
+{
+    std::string Name;
+    int Width = 0, Height = 0, Components = 0;
+    size_t FileBytes = 0, PixelBytes = 0;
+    unsigned int Threads = 1;
+    int Runs = 0;
+    double MedianMs = 0.0, P99Ms = 0.0, MinMs = 0.0;
+    double MBs = 0.0; // decoded bytes of every thread over the wall time of the case
+    long PeakRssKb = 0;
+    uint32_t Checksum = 0;
+};
+
+enum Format
+{
+    FORMAT_TABLE,
+    FORMAT_CSV,
+    FORMAT_JSON
+};
+
+static uint32_t fnv1a(const unsigned char *data, size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+// Linux can reset the resident set's high-water mark, which makes the peak RSS one of the case alone.
+// Elsewhere it stays the peak of the whole run so far
+static void resetPeakRss()
+{
+#ifdef __linux__
+    if (FILE *file = std::fopen("/proc/self/clear_refs", "w"))
+    {
+        std::fputs("5", file);
+        std::fclose(file);
+    }
+#endif
+}
+
+static long peakRssKb()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return static_cast<long>(counters.PeakWorkingSetSize / 1024);
+    return 0;
+#else
+#ifdef __linux__
+    if (FILE *file = std::fopen("/proc/self/status", "r"))
+    {
+        char line[256];
+        long kb = 0;
+        while (std::fgets(line, sizeof(line), file))
+            if (std::sscanf(line, "VmHWM: %ld", &kb) == 1)
+                break;
+        std::fclose(file);
+        if (kb > 0)
+            return kb;
+    }
+#endif
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<long>(usage.ru_maxrss / 1024); // bytes on macOS
+#else
+    return static_cast<long>(usage.ru_maxrss);
+#endif
+#endif
+}
+
+static std::vector<std::string> imageFiles(const std::string &directory)
+{
+    std::vector<std::string> names;
+#ifdef _WIN32
+    _finddata_t entry;
+    intptr_t handle = _findfirst((directory + "/*").c_str(), &entry);
+    if (handle != -1)
+    {
+        do
+            names.push_back(entry.name);
+        while (_findnext(handle, &entry) == 0);
+        _findclose(handle);
+    }
+#else
+    if (DIR *dir = opendir(directory.c_str()))
+    {
+        while (dirent *entry = readdir(dir))
+            names.push_back(entry->d_name);
+        closedir(dir);
+    }
+#endif
+    // whatever stb_image is built to read
+    const char *extensions[] = {".png", ".jpg", ".jpeg", ".bmp", ".tga", ".psd", ".gif", ".hdr", ".pic", ".pnm", ".ppm", ".pgm"};
+    std::vector<std::string> files;
+    for (const std::string &name : names)
+    {
+        std::string lower = name;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+        for (const char *extension : extensions)
+        {
+            size_t length = std::strlen(extension);
+            if (lower.size() > length && lower.compare(lower.size() - length, length, extension) == 0)
+            {
+                files.push_back(directory + "/" + name);
+                break;
+            }
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// A small PNG writer for the synthetic images: each row gets the filter with the smallest sum of
+// absolute differences, as libpng does, and the stream is deflated with greedy LZ77 matches and the
+// fixed Huffman codes. That compresses worse than zlib but exercises the same decoder paths (every
+// filter type, literals, lengths and distances) as a real asset.
+class PngWriter
+{
+public:
+    static std::vector<unsigned char> encode(const unsigned char *pixels, int width, int height, int components)
+    {
+        size_t stride = static_cast<size_t>(width) * components;
+        std::vector<unsigned char> filtered((stride + 1) * height), candidate(stride);
+        for (int y = 0; y < height; y++)
+        {
+            const unsigned char *row = pixels + y * stride, *prior = y > 0 ? row - stride : nullptr;
+            unsigned char *out = &filtered[y * (stride + 1)];
+            uint64_t best = UINT64_MAX;
+            for (int filter = 0; filter < 5; filter++)
+            {
+                uint64_t cost = 0;
+                for (size_t x = 0; x < stride; x++)
+                {
+                    int a = x >= static_cast<size_t>(components) ? row[x - components] : 0;
+                    int b = prior ? prior[x] : 0;
+                    int c = prior && x >= static_cast<size_t>(components) ? prior[x - components] : 0;
+                    int predicted[] = {0, a, b, (a + b) / 2, paeth(a, b, c)};
+                    candidate[x] = static_cast<unsigned char>(row[x] - predicted[filter]);
+                    cost += static_cast<uint64_t>(std::abs(static_cast<signed char>(candidate[x])));
+                }
+                if (cost < best)
+                {
+                    best = cost;
+                    out[0] = static_cast<unsigned char>(filter);
+                    std::memcpy(out + 1, candidate.data(), stride);
+                }
+            }
+        }
+
+        std::vector<unsigned char> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+        const unsigned char colorTypes[] = {0, 0, 4, 2, 6};
+        std::vector<unsigned char> header;
+        put32(header, static_cast<uint32_t>(width));
+        put32(header, static_cast<uint32_t>(height));
+        header.push_back(8);
+        header.push_back(colorTypes[components]);
+        header.push_back(0);
+        header.push_back(0);
+        header.push_back(0);
+        chunk(png, "IHDR", header);
+        chunk(png, "IDAT", deflate(filtered));
+        chunk(png, "IEND", std::vector<unsigned char>());
+        return png;
+    }
+
+private:
+    struct Bits
+    {
+        std::vector<unsigned char> Out;
+        uint32_t Buffer = 0;
+        int Count = 0;
+
+        void put(uint32_t value, int count) // least significant bit first
+        {
+            Buffer |= value << Count;
+            Count += count;
+            while (Count >= 8)
+            {
+                Out.push_back(static_cast<unsigned char>(Buffer));
+                Buffer >>= 8;
+                Count -= 8;
+            }
+        }
+
+        void code(uint32_t code, int length) // Huffman codes go most significant bit first
+        {
+            uint32_t reversed = 0;
+            for (int i = 0; i < length; i++)
+                reversed |= ((code >> i) & 1) << (length - 1 - i);
+            put(reversed, length);
+        }
+    };
+
+    static int paeth(int a, int b, int c)
+    {
+        int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+        return pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+    }
+
+    static void literal(Bits &bits, int symbol)
+    {
+        if (symbol < 144)
+            bits.code(0x30 + symbol, 8);
+        else if (symbol < 256)
+            bits.code(0x190 + symbol - 144, 9);
+        else if (symbol < 280)
+            bits.code(symbol - 256, 7);
+        else
+            bits.code(0xc0 + symbol - 280, 8);
+    }
+
+    static void match(Bits &bits, int length, int distance)
+    {
+        static const int lengthBase[] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const int lengthExtra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static const int distanceBase[] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                           6145, 8193, 12289, 16385, 24577};
+        static const int distanceExtra[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+        int l = 28;
+        while (lengthBase[l] > length)
+            l--;
+        literal(bits, 257 + l);
+        bits.put(length - lengthBase[l], lengthExtra[l]);
+        int d = 29;
+        while (distanceBase[d] > distance)
+            d--;
+        bits.code(d, 5);
+        bits.put(distance - distanceBase[d], distanceExtra[d]);
+    }
+
+    // zlib stream of one fixed Huffman block
+    static std::vector<unsigned char> deflate(const std::vector<unsigned char> &data)
+    {
+        const int HASH_BITS = 16, WINDOW = 32768, MAX_MATCH = 258;
+        std::vector<int64_t> head(1 << HASH_BITS, -1);
+        Bits bits;
+        bits.Out = {0x78, 0x01};
+        bits.put(1, 1); // last block
+        bits.put(1, 2); // fixed codes
+        size_t size = data.size(), i = 0;
+        while (i < size)
+        {
+            int length = 0, distance = 0;
+            if (i + 3 <= size)
+            {
+                uint32_t hash = ((data[i] << 16 | data[i + 1] << 8 | data[i + 2]) * 2654435761u) >> (32 - HASH_BITS);
+                int64_t candidate = head[hash];
+                head[hash] = static_cast<int64_t>(i);
+                if (candidate >= 0 && i - candidate <= WINDOW)
+                {
+                    size_t limit = std::min<size_t>(MAX_MATCH, size - i);
+                    while (static_cast<size_t>(length) < limit && data[candidate + length] == data[i + length])
+                        length++;
+                    distance = static_cast<int>(i - candidate);
+                }
+            }
+            if (length >= 3)
+            {
+                match(bits, length, distance);
+                i += length;
+            }
+            else
+                literal(bits, data[i++]);
+        }
+        literal(bits, 256);
+        bits.put(0, 7); // flush the last partial byte
+        uint32_t a = 1, b = 0;
+        for (unsigned char byte : data)
+        {
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+        put32(bits.Out, b << 16 | a);
+        return bits.Out;
+    }
+
+    static void put32(std::vector<unsigned char> &out, uint32_t value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8)
+            out.push_back(static_cast<unsigned char>(value >> shift));
+    }
+
+    static void chunk(std::vector<unsigned char> &png, const char *type, const std::vector<unsigned char> &data)
+    {
+        put32(png, static_cast<uint32_t>(data.size()));
+        size_t start = png.size();
+        png.insert(png.end(), type, type + 4);
+        png.insert(png.end(), data.begin(), data.end());
+        uint32_t crc = 0xffffffffu;
+        for (size_t i = start; i < png.size(); i++)
+        {
+            crc ^= png[i];
+            for (int bit = 0; bit < 8; bit++)
+                crc = crc >> 1 ^ (0xedb88320u & (0u - (crc & 1)));
+        }
+        put32(png, ~crc);
+    }
+};
+
+// smooth gradients with a little noise and a few hard edged shapes, compresses about as well as a
+// painted texture rather than as a flat color or white noise would
+static Source synthetic(int width, int height, int components)
+{
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * components);
+    uint32_t seed = 12345;
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            bool shape = ((x / 97) + (y / 61)) % 5 == 0;
+            for (int c = 0; c < components; c++)
+            {
+                float wave = std::sin(x * 0.013f * (c + 1) + y * 0.007f) * std::cos(y * 0.011f - x * 0.003f * c);
+                int value = static_cast<int>(127.5f + 100.0f * wave) + static_cast<int>((seed >> (28 + c)) & 1);
+                if (shape)
+                    value = 255 - value / 2;
+                if (c == 3)
+                    value = shape ? 255 : 160 + value / 4;
+                pixels[(static_cast<size_t>(y) * width + x) * components + c] = static_cast<unsigned char>(std::min(255, std::max(0, value)));
+            }
+        }
+    }
+    Source source;
+    source.Name = "synthetic-" + std::to_string(width) + "x" + std::to_string(height) + "x" + std::to_string(components);
+    source.Bytes = PngWriter::encode(pixels.data(), width, height, components);
+    return source;
+}
+
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+// threads decode the same image runs times each, all starting together
+static bool measure(const Source &source, unsigned int threads, int runs, Result &result)
+{
+    const unsigned char *data = source.Bytes.data();
+    int size = static_cast<int>(source.Bytes.size());
+
+    resetPeakRss();
+    // untimed: fault in the allocator and the decoder's tables, and take the checksum
+    int width, height, components;
+    unsigned char *pixels = stbi_load_from_memory(data, size, &width, &height, &components, 0);
+    if (!pixels)
+    {
+        std::printf("ERROR::DECODE_BENCH::DECODE_FAILED: %s: %s\n", source.Name.c_str(), stbi_failure_reason());
+        return false;
+    }
+    result.Name = source.Name;
+    result.Width = width;
+    result.Height = height;
+    result.Components = components;
+    result.FileBytes = source.Bytes.size();
+    result.PixelBytes = static_cast<size_t>(width) * height * components;
+    result.Checksum = fnv1a(pixels, result.PixelBytes);
+    stbi_image_free(pixels);
+
+    std::vector<std::vector<double>> times(threads);
+    auto decodeAll = [&](unsigned int thread) {
+        for (int run = 0; run < runs; run++)
+        {
+            int w, h, c;
+            auto start = std::chrono::steady_clock::now();
+            unsigned char *decoded = stbi_load_from_memory(data, size, &w, &h, &c, 0);
+            times[thread].push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            stbi_image_free(decoded);
+        }
+    };
+    auto start = std::chrono::steady_clock::now();
+    if (threads == 1)
+        decodeAll(0);
+    else
+    {
+        std::vector<std::thread> workers;
+        for (unsigned int thread = 0; thread < threads; thread++)
+            workers.emplace_back(decodeAll, thread);
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    for (const std::vector<double> &thread : times)
+        all.insert(all.end(), thread.begin(), thread.end());
+    std::sort(all.begin(), all.end());
+    result.Threads = threads;
+    result.Runs = runs;
+    result.MedianMs = percentile(all, 0.5);
+    result.P99Ms = percentile(all, 0.99);
+    result.MinMs = all.front();
+    result.MBs = result.PixelBytes * static_cast<double>(all.size()) / 1048576.0 / (wallMs / 1000.0);
+    result.PeakRssKb = peakRssKb();
+    return true;
+}
+
+static void print(const Result &r, Format format)
+{
+    if (format == FORMAT_JSON)
+        std::printf("{\"name\":\"%s\",\"width\":%d,\"height\":%d,\"components\":%d,\"file_bytes\":%zu,\"pixel_bytes\":%zu,\"threads\":%u,"
+                    "\"runs\":%d,\"median_ms\":%.4f,\"p99_ms\":%.4f,\"min_ms\":%.4f,\"mb_per_s\":%.2f,\"peak_rss_kb\":%ld,\"checksum\":\"%08x\"}\n",
+                    r.Name.c_str(), r.Width, r.Height, r.Components, r.FileBytes, r.PixelBytes, r.Threads, r.Runs, r.MedianMs, r.P99Ms, r.MinMs,
+                    r.MBs, r.PeakRssKb, r.Checksum);
+    else if (format == FORMAT_CSV)
+        std::printf("%s,%d,%d,%d,%zu,%zu,%u,%d,%.4f,%.4f,%.4f,%.2f,%ld,%08x\n", r.Name.c_str(), r.Width, r.Height, r.Components, r.FileBytes,
+                    r.PixelBytes, r.Threads, r.Runs, r.MedianMs, r.P99Ms, r.MinMs, r.MBs, r.PeakRssKb, r.Checksum);
+    else
+        std::printf("%-28s %11s %8u %10.2f %10.2f %10.1f %12ld   %08x\n", r.Name.c_str(),
+                    (std::to_string(r.Width) + "x" + std::to_string(r.Height) + "x" + std::to_string(r.Components)).c_str(), r.Threads, r.MedianMs,
+                    r.P99Ms, r.MBs, r.PeakRssKb, r.Checksum);
+}
+
+// value of "key": in one line of our own json output
+static std::string field(const std::string &line, const std::string &key)
+{
+    size_t at = line.find("\"" + key + "\":");
+    if (at == std::string::npos)
+        return std::string();
+    at += key.size() + 3;
+    if (at < line.size() && line[at] == '"')
+        return line.substr(at + 1, line.find('"', at + 1) - at - 1);
+    return line.substr(at, line.find_first_of(",}", at) - at);
+}
+
+struct Baseline
+{
+    double MedianMs;
+    std::string Checksum;
+};
+
+static bool readBaseline(const std::string &path, std::map<std::string, Baseline> &baseline)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::printf("ERROR::DECODE_BENCH::BASELINE_NOT_FOUND: %s\n", path.c_str());
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::string name = field(line, "name"), threads = field(line, "threads"), median = field(line, "median_ms");
+        if (!name.empty() && !threads.empty() && !median.empty())
+            baseline[name + "/" + threads] = Baseline{std::atof(median.c_str()), field(line, "checksum")};
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int runs = 20;
+    std::vector<unsigned int> threadCounts;
+    std::string directory = "resources/textures", only, baselinePath;
+    std::vector<std::vector<int>> sizes;
+    bool syntheticImages = true;
+    Format format = FORMAT_TABLE;
+    double tolerance = 10.0;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--runs" && hasValue)
+            runs = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--threads" && hasValue)
+        {
+            std::stringstream list(argv[++i]);
+            std::string count;
+            while (std::getline(list, count, ','))
+                threadCounts.push_back(static_cast<unsigned int>(std::max(1, std::atoi(count.c_str()))));
+        }
+        else if (arg == "--dir" && hasValue)
+            directory = argv[++i];
+        else if (arg == "--only" && hasValue)
+            only = argv[++i];
+        else if (arg == "--synthetic" && hasValue)
+        {
+            int width, height, components;
+            if (std::sscanf(argv[++i], "%dx%dx%d", &width, &height, &components) != 3 || width < 1 || height < 1 || components < 1 || components > 4)
+            {
+                std::printf("ERROR::DECODE_BENCH: --synthetic wants WIDTHxHEIGHTxCOMPONENTS, e.g. 4096x4096x4\n");
+                return 1;
+            }
+            sizes.push_back({width, height, components});
+        }
+        else if (arg == "--no-synthetic")
+            syntheticImages = false;
+        else if (arg == "--format" && hasValue)
+        {
+            std::string name = argv[++i];
+            if (name == "table")
+                format = FORMAT_TABLE;
+            else if (name == "csv")
+                format = FORMAT_CSV;
+            else if (name == "json")
+                format = FORMAT_JSON;
+            else
+            {
+                std::printf("ERROR::DECODE_BENCH: Unknown format %s\n", name.c_str());
+                return 1;
+            }
+        }
+        else if (arg == "--baseline" && hasValue)
+            baselinePath = argv[++i];
+        else if (arg == "--tolerance" && hasValue)
+            tolerance = std::atof(argv[++i]);
+        else
+        {
+            std::printf("ERROR::DECODE_BENCH: Unknown argument %s\n", arg.c_str());
+            return 1;
+        }
+    }
+    if (threadCounts.empty())
+    {
+        threadCounts.push_back(1);
+        unsigned int cores = std::thread::hardware_concurrency();
+        if (cores > 1)
+            threadCounts.push_back(cores);
+    }
+    if (sizes.empty())
+        sizes = {{2048, 2048, 3}, {4096, 4096, 4}};
+
+    std::map<std::string, Baseline> baseline;
+    if (!baselinePath.empty() && !readBaseline(baselinePath, baseline))
+        return 1;
+
+    std::vector<Source> sources;
+    for (const std::string &path : imageFiles(directory))
+    {
+        MappedFile file(path);
+        if (!file.isOpen())
+            continue;
+        Source source;
+        source.Name = path.substr(path.find_last_of("/\\") + 1);
+        source.Bytes.assign(file.data(), file.data() + file.size());
+        sources.push_back(std::move(source));
+    }
+    if (syntheticImages)
+    {
+        for (const std::vector<int> &size : sizes)
+        {
+            std::string name = "synthetic-" + std::to_string(size[0]) + "x" + std::to_string(size[1]) + "x" + std::to_string(size[2]);
+            if (only.empty() || name.find(only) != std::string::npos)
+                sources.push_back(synthetic(size[0], size[1], size[2]));
+        }
+    }
+    if (!only.empty())
+        sources.erase(std::remove_if(sources.begin(), sources.end(), [&](const Source &s) { return s.Name.find(only) == std::string::npos; }),
+                      sources.end());
+    if (sources.empty())
+    {
+        std::printf("ERROR::DECODE_BENCH: No images in %s\n", directory.c_str());
+        return 1;
+    }
+
+    // json and csv keep stdout machine readable, the comparison with the baseline goes to stderr
+    FILE *notes = format == FORMAT_TABLE ? stdout : stderr;
+    if (format == FORMAT_TABLE)
+    {
+#ifdef STBI_FAST_PNG
+        std::printf("stb_image fast path: on, %d runs per thread\n", runs);
+#else
+        std::printf("stb_image fast path: off, %d runs per thread\n", runs);
+#endif
+        std::printf("%-28s %11s %8s %10s %10s %10s %12s %10s\n", "image", "size", "threads", "median ms", "p99 ms", "MB/s", "peak RSS KB", "checksum");
+    }
+    else if (format == FORMAT_CSV)
+        std::printf("name,width,height,components,file_bytes,pixel_bytes,threads,runs,median_ms,p99_ms,min_ms,mb_per_s,peak_rss_kb,checksum\n");
+
+    int regressions = 0;
+    for (const Source &source : sources)
+    {
+        for (unsigned int threads : threadCounts)
+        {
+            Result result;
+            if (!measure(source, threads, runs, result))
+            {
+                regressions++;
+                continue;
+            }
+            print(result, format);
+            std::fflush(stdout);
+
+            auto old = baseline.find(result.Name + "/" + std::to_string(threads));
+            if (baselinePath.empty())
+                continue;
+            if (old == baseline.end())
+            {
+                std::fprintf(notes, "  %s, %u threads: not in the baseline\n", result.Name.c_str(), threads);
+                continue;
+            }
+            char checksum[9];
+            std::snprintf(checksum, sizeof(checksum), "%08x", result.Checksum);
+            double change = (result.MedianMs / old->second.MedianMs - 1.0) * 100.0;
+            if (old->second.Checksum != checksum)
+            {
+                std::fprintf(notes, "  MISMATCH %s, %u threads: checksum %s, baseline %s\n", result.Name.c_str(), threads, checksum,
+                             old->second.Checksum.c_str());
+                regressions++;
+            }
+            if (change > tolerance)
+            {
+                std::fprintf(notes, "  REGRESSION %s, %u threads: median %.2f ms, baseline %.2f ms (%+.1f%%)\n", result.Name.c_str(), threads,
+                             result.MedianMs, old->second.MedianMs, change);
+                regressions++;
+            }
+        }
+    }
+    if (!baselinePath.empty())
+        std::fprintf(notes, "%d regression%s against %s (tolerance %.0f%%)\n", regressions, regressions == 1 ? "" : "s", baselinePath.c_str(), tolerance);
+    return regressions > 0 ? 1 : 0;
+}
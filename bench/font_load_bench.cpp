@@ -0,0 +1,67 @@
+// Measures how long it takes to rasterize a font's glyph set with GlyphRasterizer for 1, 2, 4, ...
+// worker threads, in both bitmap and SDF mode. Needs no GL context.
+// usage: FontLoadBench [font] [codepoints]
+#include <glyph_rasterizer.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+static double rasterizeMs(const RasterizerOptions &options, const std::vector<uint32_t> &codepoints, unsigned int threads, size_t &loaded)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<RasterizedGlyph> glyphs = GlyphRasterizer::rasterize(options, codepoints, threads);
+    auto stop = std::chrono::steady_clock::now();
+    loaded = 0;
+    for (const RasterizedGlyph &g : glyphs)
+        loaded += g.Loaded ? 1 : 0;
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    std::string font = argc > 1 ? argv[1] : "resources/fonts/arial.ttf";
+    uint32_t count = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 0;
+
+    // every codepoint the font maps, or the first count of them
+    std::vector<uint32_t> codepoints;
+    {
+        FT_Library ft;
+        FT_Face face;
+        if (!GlyphRasterizer::open(RasterizerOptions{font, 48, false, 0}, ft, face))
+            return -1;
+        FT_UInt index;
+        for (FT_ULong c = FT_Get_First_Char(face, &index); index != 0; c = FT_Get_Next_Char(face, c, &index))
+        {
+            codepoints.push_back(static_cast<uint32_t>(c));
+            if (count && codepoints.size() == count)
+                break;
+        }
+        FT_Done_Face(face);
+        FT_Done_FreeType(ft);
+    }
+
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("%s: %zu codepoints, %u hardware threads\n", font.c_str(), codepoints.size(), cores);
+    std::printf("%-8s %8s %10s %8s\n", "mode", "threads", "ms", "speedup");
+
+    const RasterizerOptions modes[] = {
+        RasterizerOptions{font, 48, false, 0},
+        RasterizerOptions{font, 32, true, 6},
+    };
+    for (const RasterizerOptions &options : modes)
+    {
+        double serial = 0.0;
+        for (unsigned int threads = 1; threads <= std::max(cores, 4u); threads *= 2)
+        {
+            size_t loaded;
+            double ms = rasterizeMs(options, codepoints, threads, loaded);
+            if (threads == 1)
+                serial = ms;
+            std::printf("%-8s %8u %10.1f %7.2fx\n", options.Sdf ? "sdf" : "bitmap", threads, ms, serial / ms);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+// Measures MipGenerator on one image for every filter: the scalar reference, the SSE/AVX loops on one
+// thread and the SSE/AVX loops on 2, 4, ... threads, and checks the vector output against the scalar
+// one. Needs no GL context.
+// usage: MipBench [image] [runs]   default resources/textures/tu.png, 5 runs
+#include <mip_generator.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+// median milliseconds of building the chain runs times after one untimed run, the last chain is left in mips
+static double chainMs(const unsigned char *pixels, int width, int height, int components, const MipOptions &options, int runs, MipChain &mips)
+{
+    mips = MipGenerator::chain(pixels, width, height, components, options); // warm up the allocator and tables
+    std::vector<double> times;
+    for (int run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        mips = MipGenerator::chain(pixels, width, height, components, options);
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+static int maxDifference(const MipChain &a, const MipChain &b)
+{
+    int diff = 0;
+    for (size_t i = 0; i < a.Data.size(); i++)
+        diff = std::max(diff, std::abs(a.Data[i] - b.Data[i]));
+    return diff;
+}
+
+int main(int argc, char **argv)
+{
+    std::string path = argc > 1 ? argv[1] : "resources/textures/tu.png";
+    int runs = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+
+    int width, height, components;
+    unsigned char *pixels = stbi_load(path.c_str(), &width, &height, &components, 0);
+    if (!pixels)
+    {
+        std::printf("Could not load %s\n", path.c_str());
+        return -1;
+    }
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    double megabytes = static_cast<double>(width) * height * components / 1048576.0;
+    std::printf("%s: %dx%d, %d components, %u hardware threads, median of %d runs\n", path.c_str(), width, height, components, cores, runs);
+#if defined(MIP_GENERATOR_AVX2)
+    std::printf("vector loops: SSE2 + AVX2\n");
+#elif defined(MIP_GENERATOR_SSE2)
+    std::printf("vector loops: SSE2\n");
+#else
+    std::printf("vector loops: none, the vector rows run the scalar code\n");
+#endif
+    std::printf("%-14s %-7s %8s %10s %10s %8s %9s\n", "filter", "code", "threads", "ms", "MB/s", "speedup", "max diff");
+
+    struct
+    {
+        const char *Name;
+        MipFilter Filter;
+        bool Srgb;
+        float AlphaCutoff;
+    } filters[] = {
+        {"box", MIP_BOX, false, 0.0f},
+        {"box srgb", MIP_BOX, true, 0.0f},
+        {"kaiser", MIP_KAISER, false, 0.0f},
+        {"lanczos", MIP_LANCZOS, false, 0.0f},
+        {"lanczos srgb", MIP_LANCZOS, true, 0.0f},
+        {"box coverage", MIP_BOX, false, 0.5f},
+    };
+    for (const auto &filter : filters)
+    {
+        MipOptions options;
+        options.Filter = filter.Filter;
+        options.Srgb = filter.Srgb;
+        options.AlphaCutoff = filter.AlphaCutoff;
+        options.Threads = 1;
+        options.Vectorize = false;
+        MipChain reference, mips;
+        double scalar = chainMs(pixels, width, height, components, options, runs, reference);
+        std::printf("%-14s %-7s %8u %10.2f %10.1f %8s %9s\n", filter.Name, "scalar", 1u, scalar, megabytes / (scalar / 1000.0), "1.00x", "-");
+
+        options.Vectorize = true;
+        for (unsigned int threads = 1; threads <= std::max(cores, 2u); threads *= 2)
+        {
+            options.Threads = threads;
+            double ms = chainMs(pixels, width, height, components, options, runs, mips);
+            std::printf("%-14s %-7s %8u %10.2f %10.1f %7.2fx %9d\n", filter.Name, "simd", threads, ms, megabytes / (ms / 1000.0), scalar / ms,
+                        maxDifference(reference, mips));
+        }
+    }
+    stbi_image_free(pixels);
+    return 0;
+}
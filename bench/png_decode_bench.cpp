@@ -0,0 +1,115 @@
+// Decodes every PNG in a directory from memory with stbi_load_from_memory and reports the median time
+// and throughput per file. The checksum column is a hash of the decoded pixels, so a build with
+// -DFAST_PNG=OFF can be diffed against the fast path. Needs no GL context.
+//
+// usage: PngDecodeBench [runs] [directory]   default 9 runs over resources/textures
+#include <mapped_file.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <dirent.h>
+#endif
+
+static std::vector<std::string> pngFiles(const std::string &directory)
+{
+    std::vector<std::string> files;
+#ifdef _WIN32
+    _finddata_t entry;
+    intptr_t handle = _findfirst((directory + "/*.png").c_str(), &entry);
+    if (handle != -1)
+    {
+        do
+            files.push_back(directory + "/" + entry.name);
+        while (_findnext(handle, &entry) == 0);
+        _findclose(handle);
+    }
+#else
+    if (DIR *dir = opendir(directory.c_str()))
+    {
+        while (dirent *entry = readdir(dir))
+        {
+            std::string name = entry->d_name;
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".png") == 0)
+                files.push_back(directory + "/" + name);
+        }
+        closedir(dir);
+    }
+#endif
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+static uint32_t fnv1a(const unsigned char *data, size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+int main(int argc, char **argv)
+{
+    int runs = argc > 1 ? std::max(1, std::atoi(argv[1])) : 9;
+    std::string directory = argc > 2 ? argv[2] : "resources/textures";
+    std::vector<std::string> files = pngFiles(directory);
+    if (files.empty())
+    {
+        std::printf("No PNG files in %s\n", directory.c_str());
+        return -1;
+    }
+#ifdef STBI_FAST_PNG
+    std::printf("stb_image fast path: on, median of %d runs\n", runs);
+#else
+    std::printf("stb_image fast path: off, median of %d runs\n", runs);
+#endif
+    std::printf("%-28s %10s %10s %9s %10s %10s %10s\n", "file", "png KB", "pixel KB", "ms", "MB/s out", "MB/s in", "checksum");
+
+    double totalMs = 0.0, totalIn = 0.0, totalOut = 0.0;
+    for (const std::string &path : files)
+    {
+        MappedFile file(path);
+        if (!file.isOpen())
+            continue;
+        std::vector<double> times;
+        size_t bytes = 0;
+        uint32_t checksum = 0;
+        for (int run = 0; run < runs; run++)
+        {
+            int width, height, components;
+            auto start = std::chrono::steady_clock::now();
+            unsigned char *pixels = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &components, 0);
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            if (!pixels)
+            {
+                std::printf("%s: %s\n", path.c_str(), stbi_failure_reason());
+                break;
+            }
+            bytes = static_cast<size_t>(width) * height * components;
+            checksum = fnv1a(pixels, bytes);
+            stbi_image_free(pixels);
+        }
+        if (!bytes)
+            continue;
+        std::sort(times.begin(), times.end());
+        double ms = times[times.size() / 2];
+        std::string name = path.substr(path.find_last_of("/\\") + 1);
+        std::printf("%-28s %10.1f %10.1f %9.2f %10.1f %10.1f   %08x\n", name.c_str(), file.size() / 1024.0, bytes / 1024.0, ms,
+                    bytes / 1048576.0 / (ms / 1000.0), file.size() / 1048576.0 / (ms / 1000.0), checksum);
+        totalMs += ms;
+        totalIn += file.size();
+        totalOut += bytes;
+    }
+    std::printf("%-28s %10.1f %10.1f %9.2f %10.1f %10.1f\n", "total", totalIn / 1024.0, totalOut / 1024.0, totalMs, totalOut / 1048576.0 / (totalMs / 1000.0),
+                totalIn / 1048576.0 / (totalMs / 1000.0));
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Measures batched text throughput: queues a full screen of glyphs through UiText every frame and
+// flushes it, reporting glyphs per second (CPU submission + GPU completion, vsync off).
+// Pass "instanced" as the second argument to go through drawDynamicText instead of drawText.
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <shader.h>
+#include <frame_data.h>
+#include <ui_text.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+int main(int argc, char **argv)
+{
+    int frames = argc > 1 ? std::stoi(argv[1]) : 200;
+    bool instanced = argc > 2 && std::string(argv[2]) == "instanced";
+    const int width = 1920, height = 1080;
+    const int lines = 100, columns = 120; // 12000 glyphs per frame
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    GLFWwindow *window = glfwCreateWindow(width, height, "TextBench", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    GLState::get().setBlend(true);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    Shader textShader(instanced ? "resources/shaders/text_instanced.vs" : "resources/shaders/text.vs", "resources/shaders/text.fs");
+    FrameUniforms frameUniforms;
+    FrameData screen = FrameUniforms::make(glm::ortho(0.0f, (float)width, 0.0f, (float)height), glm::mat4(1.0f), glm::vec3(0.0f), 0.0f);
+    frameUniforms.update(screen, screen);
+    frameUniforms.bind(FrameUniforms::SCREEN);
+
+    UiText uiText;
+    std::string line;
+    for (int i = 0; i < columns; i++)
+        line += static_cast<char>('!' + i % 94);
+
+    size_t glyphs = 0;
+    double submitSeconds = 0.0;
+    glFinish();
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        glClear(GL_COLOR_BUFFER_BIT);
+        auto submit = std::chrono::steady_clock::now();
+        for (int i = 0; i < lines; i++)
+        {
+            glm::vec3 color(i % 3 == 0, i % 3 == 1, i % 3 == 2);
+            if (instanced)
+                uiText.drawDynamicText(textShader, line, 0.0f, height - 10.0f * (i + 1), 0.2f, color);
+            else
+                uiText.drawText(textShader, line, 0.0f, height - 10.0f * (i + 1), 0.2f, color);
+        }
+        glyphs += lines * columns;
+        uiText.flush();
+        submitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - submit).count();
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+    glFinish();
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    size_t bytesPerGlyph = instanced ? sizeof(GlyphInstance) : 4 * sizeof(TextVertex);
+    std::cout << lines * columns << " glyphs/frame, " << frames << " frames, " << (instanced ? "instanced" : "batched") << std::endl;
+    std::cout << "  " << frames / seconds << " frames/s, " << glyphs / seconds << " glyphs/s" << std::endl;
+    std::cout << "  CPU layout + submit " << submitSeconds * 1000.0 / frames << " ms/frame, upload "
+              << lines * columns * bytesPerGlyph / 1024 << " KB/frame" << std::endl;
+    glfwTerminate();
+    return 0;
+}
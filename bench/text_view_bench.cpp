@@ -0,0 +1,95 @@
+// Measures the per-frame cost of a TextView following a live log: the document is pre-filled with
+// a large number of lines, then every frame appends more lines and draws the view. Reports the
+// average and worst CPU frame time, which should not depend on the document size.
+// usage: TextViewBench [document lines] [lines appended per frame] [wrap 0/1]
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <shader.h>
+#include <frame_data.h>
+#include <ui_text.h>
+#include <text_view.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+static std::string logLine(size_t i)
+{
+    return "[" + std::to_string(i) + "] INFO worker finished job in 12.5 ms, queue depth 7, waiting for more work\n";
+}
+
+int main(int argc, char **argv)
+{
+    size_t documentLines = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    int appendPerFrame = argc > 2 ? std::stoi(argv[2]) : 167; // 10k lines/s at 60 fps
+    bool wrap = argc > 3 && std::stoi(argv[3]) != 0;
+    const int width = 1280, height = 720, frames = 300;
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    GLFWwindow *window = glfwCreateWindow(width, height, "TextViewBench", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    GLState::get().setBlend(true);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    Shader textShader("resources/shaders/text.vs", "resources/shaders/sdf_text.fs");
+    FrameUniforms frameUniforms;
+    FrameData screen = FrameUniforms::make(glm::ortho(0.0f, (float)width, 0.0f, (float)height), glm::mat4(1.0f), glm::vec3(0.0f), 0.0f);
+    frameUniforms.update(screen, screen);
+    frameUniforms.bind(FrameUniforms::SCREEN);
+
+    UiText uiText(TEXT_SDF, "resources/fonts/arial_sdf.bfnt");
+    TextView view(uiText, 10.0f, 10.0f, width - 20.0f, height - 20.0f, 0.4f, wrap);
+    auto fillStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < documentLines; i++)
+        view.append(logLine(i));
+    double fillSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - fillStart).count();
+
+    // the first draw rasterizes the glyphs, keep it out of the timed frames
+    view.draw(textShader);
+    glFinish();
+
+    double total = 0.0, worst = 0.0;
+    size_t next = documentLines;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        glClear(GL_COLOR_BUFFER_BIT);
+        for (int i = 0; i < appendPerFrame; i++)
+            view.append(logLine(next++));
+        view.draw(textShader);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        total += ms;
+        worst = std::max(worst, ms);
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    std::cout << documentLines << " lines filled in " << fillSeconds * 1000.0 << " ms (" << documentLines / fillSeconds << " lines/s)" << std::endl;
+    std::cout << "  " << view.rowCount() << " rows, " << view.visibleRows() << " visible, wrap " << (wrap ? "on" : "off") << std::endl;
+    std::cout << "  " << appendPerFrame << " appends + draw per frame: avg " << total / frames << " ms, worst " << worst << " ms" << std::endl;
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,190 @@
+// Compares loading the texture set as PNG (stbi_load + glTexImage2D + glGenerateMipmap), as PNG decoded
+// straight into a mapped pixel buffer (ImageLoader + UploadRing) and as the baked .btex files (map + one
+// glTexImage2D per stored level). All run synchronously on the GL thread and end with glFinish, so the
+// numbers are the full cost of getting a mipmapped texture.
+// Run from the build directory after the BakedTextures target; files are warm in the page cache.
+//
+// usage: TextureLoadBench [runs] [names...]   names without extension, default: every demo texture
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <baked_texture.h>
+#include <gl_state.h>
+#include <image_loader.h>
+#include <mapped_file.h>
+#include <stb_image.h>
+#include <upload_ring.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static GLuint loadPng(const std::string &path, size_t &fileBytes, size_t &textureBytes)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    MappedFile file(path);
+    int width, height, components;
+    unsigned char *data = file.isOpen() ? stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &components, 0) : nullptr;
+    if (!data)
+    {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+        return texture;
+    }
+    const GLenum formats[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+    GLenum format = formats[components - 1];
+    GLState::get().bindTextureForUpdate(0, GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    stbi_image_free(data);
+    fileBytes += file.size();
+    textureBytes += static_cast<size_t>(width) * height * components * 4 / 3;
+    return texture;
+}
+
+static UploadRing *Ring = nullptr;
+
+// no stb_image allocation and no copy out of it: the pixels are written once, into the buffer GL reads
+static GLuint loadPngMapped(const std::string &path, size_t &fileBytes, size_t &textureBytes)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    MappedFile file(path);
+    ImageInfo info;
+    unsigned char *mapped = nullptr;
+    if (file.isOpen() && ImageLoader::info(file.data(), file.size(), info))
+        mapped = Ring->map(info.size(), true);
+    if (!mapped)
+    {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+        return texture;
+    }
+    bool decoded = ImageLoader::decode(file.data(), file.size(), mapped, info.size());
+    Ring->unmap();
+    if (decoded)
+    {
+        const GLenum formats[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+        GLenum format = formats[info.Components - 1];
+        GLState::get().bindTextureForUpdate(0, GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, info.Width, info.Height, 0, format, GL_UNSIGNED_BYTE, (void *)0);
+    }
+    Ring->submit();
+    if (!decoded)
+        return texture;
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    fileBytes += file.size();
+    textureBytes += info.size() * 4 / 3;
+    return texture;
+}
+
+static GLuint loadBaked(const std::string &path, size_t &fileBytes, size_t &textureBytes)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    BakedTexture baked;
+    if (!baked.open(path))
+        return texture;
+    const BakedTextureHeader &header = baked.header();
+    GLState::get().bindTextureForUpdate(0, GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (uint32_t i = 0; i < header.Levels; i++)
+    {
+        const BakedTextureLevel &level = baked.level(i);
+        glTexImage2D(GL_TEXTURE_2D, i, header.InternalFormat, level.Width, level.Height, 0, header.Format, GL_UNSIGNED_BYTE, baked.pixels(i));
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header.Levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    fileBytes += static_cast<size_t>(baked.dataSize());
+    textureBytes += static_cast<size_t>(baked.dataSize());
+    return texture;
+}
+
+typedef GLuint (*Loader)(const std::string &, size_t &, size_t &);
+
+// median milliseconds of loading every file runs times
+static double measure(Loader load, const std::vector<std::string> &paths, int runs, size_t &fileBytes, size_t &textureBytes)
+{
+    std::vector<double> times;
+    for (int run = 0; run < runs; run++)
+    {
+        fileBytes = textureBytes = 0;
+        std::vector<GLuint> textures;
+        glFinish();
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string &path : paths)
+            textures.push_back(load(path, fileBytes, textureBytes));
+        glFinish();
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        for (GLuint texture : textures)
+            GLState::get().deleteTexture(texture);
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+int main(int argc, char **argv)
+{
+    int runs = argc > 1 ? std::max(1, std::stoi(argv[1])) : 5;
+    std::vector<std::string> names;
+    for (int i = 2; i < argc; i++)
+        names.push_back(argv[i]);
+    if (names.empty())
+        names = {"container2", "container2_specular", "meguminnnnn", "tu", "tu-sdf64", "tu-sdf128", "tu-sdf512"};
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    GLFWwindow *window = glfwCreateWindow(64, 64, "TextureLoadBench", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    std::vector<std::string> png, baked;
+    for (const std::string &name : names)
+    {
+        png.push_back("resources/textures/" + name + ".png");
+        baked.push_back("resources/textures/" + name + ".btex");
+    }
+
+    std::cout << names.size() << " textures, median of " << runs << " runs" << std::endl;
+    struct
+    {
+        const char *Name;
+        Loader Load;
+        const std::vector<std::string> *Paths;
+    } formats[] = {{"png       ", loadPng, &png}, {"png -> pbo", loadPngMapped, &png}, {"btex      ", loadBaked, &baked}};
+    {
+        UploadRing ring;
+        Ring = &ring;
+        for (const auto &format : formats)
+        {
+            size_t fileBytes, textureBytes;
+            double ms = measure(format.Load, *format.Paths, runs, fileBytes, textureBytes);
+            std::printf("  %s: %8.2f ms  %6.1f MB read  %7.1f MB/s of mipmapped texels\n", format.Name, ms, fileBytes / 1048576.0,
+                        textureBytes / 1048576.0 / (ms / 1000.0));
+        }
+    }
+    glfwTerminate();
+    return 0;
+}
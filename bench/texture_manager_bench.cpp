@@ -0,0 +1,117 @@
+// Exercises TextureManager's budget. First a check that a texture released and acquired again within one
+// frame goes back to the hot end of the LRU, so pump() can still evict the unreferenced textures behind
+// it; then a camera sweeping over a row of textures, a window of them visible per frame, under a budget
+// that holds only part of the row. Reports the texture work per frame (evicting, reloading and
+// uploading), evictions and the resident estimate against the budget. Exits with 1 when the check fails.
+// Run from the build directory so that resources/ is found.
+//
+// usage: TextureManagerBench [frames] [visible]   default 200 frames, 3 textures visible
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <texture_manager.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const char *const Textures[] = {"resources/textures/container2.png", "resources/textures/container2_specular.png",
+                                       "resources/textures/meguminnnnn.png", "resources/textures/tu-sdf512.png",
+                                       "resources/textures/tu-sdf128.png", "resources/textures/tu-sdf64.png", "resources/textures/tu.png"};
+static const int TEXTURE_COUNT = sizeof(Textures) / sizeof(Textures[0]);
+
+// release every handle, take one back in the same frame, then pump: only the re-acquired one may stay
+static bool reacquireInOneFrame()
+{
+    TextureManager manager(0);
+    TextureHandle kept = manager.acquire(Textures[0]);
+    manager.finish();
+    size_t one = manager.residentBytes();
+    manager.setBudget(one);
+    {
+        TextureHandle a = manager.acquire(Textures[1]), b = manager.acquire(Textures[2]);
+        manager.finish();
+        manager.pump();
+        kept.get();
+        b.get();
+    } // a and b are unreferenced now and go to the cold end
+    kept = TextureHandle();
+    kept = manager.acquire(Textures[0]); // same frame as its release
+    manager.pump();
+    bool passed = manager.residentBytes() <= manager.budget() && manager.ready(kept);
+    std::printf("release + acquire + pump in one frame: resident %zu KB, budget %zu KB, %zu evictions: %s\n", manager.residentBytes() / 1024,
+                manager.budget() / 1024, manager.evictions(), passed ? "ok" : "FAILED");
+    return passed;
+}
+
+static void sweep(int frames, int visible)
+{
+    size_t all = 0;
+    {
+        TextureManager probe;
+        for (const char *path : Textures)
+            probe.acquire(path);
+        all = probe.residentBytes();
+        probe.finish();
+    }
+    TextureManager manager(all / 2);
+    std::vector<TextureHandle> handles;
+    for (const char *path : Textures)
+        handles.push_back(manager.acquire(path));
+
+    std::vector<double> times;
+    size_t peak = 0, over = 0;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        manager.pump();
+        peak = std::max(peak, manager.residentBytes());
+        over += manager.residentBytes() > manager.budget() ? 1 : 0;
+        int first = (frame / 4) % TEXTURE_COUNT; // moves on every fourth frame
+        for (int i = 0; i < visible; i++)
+            handles[(first + i) % TEXTURE_COUNT].get();
+        manager.finish(); // the visible set is always complete, so each frame pays for its reloads in full
+        glFinish();
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    std::printf("sweep, %d of %d visible: budget %zu KB of %zu KB, peak resident %zu KB, over budget after %zu of %d pumps, %zu evictions\n",
+                visible, TEXTURE_COUNT, manager.budget() / 1024, all / 1024, peak / 1024, over, frames, manager.evictions());
+    std::printf("  texture work per frame: median %.3f ms, max %.3f ms\n", times[times.size() / 2], times.back());
+}
+
+int main(int argc, char **argv)
+{
+    int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200;
+    int visible = argc > 2 ? std::min(TEXTURE_COUNT, std::max(1, std::atoi(argv[2]))) : 3;
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    GLFWwindow *window = glfwCreateWindow(64, 64, "TextureManagerBench", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    bool passed = reacquireInOneFrame();
+    sweep(frames, visible);
+    glfwTerminate();
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+// Measures the CPU cost of setting a uniform through the different Shader paths:
+//   lookup - std::string + glGetUniformLocation per call (the old Shader behaviour)
+//   name   - compile-time hashed name probed in the shader's uniform table
+//   handle - location resolved once up front
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+
+#include <shader.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+static void setMat4ByLookup(const Shader &shader, const std::string &name, const glm::mat4 &mat)
+{
+    glUniformMatrix4fv(glGetUniformLocation(shader.ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+}
+
+template <typename F>
+static double nanosecondsPerCall(int iterations, F f)
+{
+    glFinish();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        f(i);
+    glFinish();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? std::stoi(argv[1]) : 1000000;
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    GLFWwindow *window = glfwCreateWindow(64, 64, "UniformBench", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    Shader shader("resources/shaders/basic_lighting.vs", "resources/shaders/basic_lighting.fs");
+    shader.use();
+    glm::mat4 model(1.0f);
+    UniformHandle modelUniform = shader.uniform("model"_u);
+
+    double lookup = nanosecondsPerCall(iterations, [&](int i) {
+        model[3][0] = (float)i;
+        setMat4ByLookup(shader, "model", model);
+    });
+    double name = nanosecondsPerCall(iterations, [&](int i) {
+        model[3][0] = (float)i;
+        shader.setMat4("model"_u, model);
+    });
+    double handle = nanosecondsPerCall(iterations, [&](int i) {
+        model[3][0] = (float)i;
+        shader.setMat4(modelUniform, model);
+    });
+
+    std::cout << "setMat4 x " << iterations << " (ns/call)" << std::endl;
+    std::cout << "  lookup: " << lookup << std::endl;
+    std::cout << "  name:   " << name << std::endl;
+    std::cout << "  handle: " << handle << std::endl;
+
+    glfwTerminate();
+    return 0;
+}
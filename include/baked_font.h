@@ -0,0 +1,138 @@
+#ifndef BAKED_FONT_H
+#define BAKED_FONT_H
+
+#include <mapped_file.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// File layout written by tools/font_baker.cpp, native byte order:
+//   BakedFontHeader
+//   BakedGlyph[GlyphCount]      sorted by codepoint
+//   BakedKerning[KerningCount]  sorted by (Left, Right)
+//   AtlasWidth * AtlasHeight    R8 texels, rows top to bottom
+// Glyph rects follow the GlyphAtlas convention: one empty texel of padding right of and below each glyph.
+const uint32_t BAKED_FONT_VERSION = 1;
+
+struct BakedFontHeader
+{
+    char Magic[4]; // "BFNT"
+    uint32_t Version;
+    uint32_t PixelSize;
+    uint32_t Sdf;
+    uint32_t Spread;
+    int32_t Ascender;   // 1/64 pixel
+    int32_t Descender;  // 1/64 pixel, negative
+    int32_t LineHeight; // 1/64 pixel
+    uint32_t GlyphCount;
+    uint32_t KerningCount;
+    uint32_t AtlasWidth;
+    uint32_t AtlasHeight;
+    uint64_t GlyphOffset;
+    uint64_t KerningOffset;
+    uint64_t PixelOffset;
+};
+
+struct BakedGlyph
+{
+    uint32_t Codepoint;
+    uint16_t X, Y;          // top left of the bitmap in the atlas
+    uint16_t Width, Height; // bitmap size without padding
+    int16_t Left, Top;      // bearing
+    int32_t Advance;        // 1/64 pixel
+};
+
+struct BakedKerning
+{
+    uint32_t Left, Right;
+    int32_t X; // 1/64 pixel
+};
+
+// A baked font file mapped into memory. Nothing is copied, the accessors point into the mapping.
+class BakedFont
+{
+public:
+    bool open(const std::string &path)
+    {
+        Valid = false;
+        if (!File.open(path))
+            return false;
+        const BakedFontHeader *header = reinterpret_cast<const BakedFontHeader *>(File.data());
+        if (File.size() < sizeof(BakedFontHeader) || std::string(header->Magic, 4) != "BFNT" || header->Version != BAKED_FONT_VERSION)
+        {
+            std::cout << "ERROR::BAKED_FONT::INVALID_FILE: " << path << std::endl;
+            File.close();
+            return false;
+        }
+        uint64_t pixels = static_cast<uint64_t>(header->AtlasWidth) * header->AtlasHeight;
+        if (header->GlyphOffset + header->GlyphCount * sizeof(BakedGlyph) > File.size() ||
+            header->KerningOffset + header->KerningCount * sizeof(BakedKerning) > File.size() ||
+            header->PixelOffset + pixels > File.size())
+        {
+            std::cout << "ERROR::BAKED_FONT::TRUNCATED_FILE: " << path << std::endl;
+            File.close();
+            return false;
+        }
+        Valid = true;
+        return true;
+    }
+
+    void close()
+    {
+        File.close();
+        Valid = false;
+    }
+
+    bool isOpen() const
+    {
+        return Valid;
+    }
+
+    const BakedFontHeader &header() const
+    {
+        return *reinterpret_cast<const BakedFontHeader *>(File.data());
+    }
+
+    const BakedGlyph *glyphsBegin() const
+    {
+        return reinterpret_cast<const BakedGlyph *>(File.data() + header().GlyphOffset);
+    }
+
+    const BakedGlyph *glyphsEnd() const
+    {
+        return glyphsBegin() + header().GlyphCount;
+    }
+
+    const BakedKerning *kerningBegin() const
+    {
+        return reinterpret_cast<const BakedKerning *>(File.data() + header().KerningOffset);
+    }
+
+    const BakedKerning *kerningEnd() const
+    {
+        return kerningBegin() + header().KerningCount;
+    }
+
+    // atlas texels, header().AtlasWidth bytes per row
+    const unsigned char *pixels() const
+    {
+        return File.data() + header().PixelOffset;
+    }
+
+    // nullptr when the codepoint was not baked
+    const BakedGlyph *find(uint32_t codepoint) const
+    {
+        if (!Valid)
+            return nullptr;
+        const BakedGlyph *it = std::lower_bound(glyphsBegin(), glyphsEnd(), codepoint,
+                                                [](const BakedGlyph &g, uint32_t c) { return g.Codepoint < c; });
+        return it != glyphsEnd() && it->Codepoint == codepoint ? it : nullptr;
+    }
+
+private:
+    MappedFile File;
+    bool Valid = false;
+};
+#endif
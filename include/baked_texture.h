@@ -0,0 +1,133 @@
+#ifndef BAKED_TEXTURE_H
+#define BAKED_TEXTURE_H
+
+#include <glad/glad.h>
+
+#include <mapped_file.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// File layout written by tools/texture_baker.cpp, native byte order:
+//   BakedTextureHeader
+//   BakedTextureLevel[Levels]   level 0 first
+//   texels of every level       tightly packed rows in stbi_load order, levels back to back
+// Formats are the GL enums the loader passes to glTexImage2D as they are.
+const uint32_t BAKED_TEXTURE_VERSION = 1;
+
+struct BakedTextureHeader
+{
+    char Magic[4]; // "BTEX"
+    uint32_t Version;
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t Components;     // bytes per texel
+    uint32_t InternalFormat; // e.g. GL_RGBA8
+    uint32_t Format;         // e.g. GL_RGBA
+    uint32_t Levels;
+};
+
+struct BakedTextureLevel
+{
+    uint32_t Width, Height;
+    uint64_t Offset; // from the start of the file
+    uint64_t Size;   // bytes
+};
+
+// A baked texture mapped into memory, the level accessors point into the mapping.
+class BakedTexture
+{
+public:
+    bool open(const std::string &path)
+    {
+        Valid = false;
+        if (!File.open(path))
+            return false;
+        const BakedTextureHeader *header = reinterpret_cast<const BakedTextureHeader *>(File.data());
+        if (File.size() < sizeof(BakedTextureHeader) || std::string(header->Magic, 4) != "BTEX" || header->Version != BAKED_TEXTURE_VERSION ||
+            header->Levels == 0 || header->Levels > 32)
+        {
+            std::cout << "ERROR::BAKED_TEXTURE::INVALID_FILE: " << path << std::endl;
+            File.close();
+            return false;
+        }
+        if (sizeof(BakedTextureHeader) + header->Levels * sizeof(BakedTextureLevel) > File.size())
+        {
+            std::cout << "ERROR::BAKED_TEXTURE::TRUNCATED_FILE: " << path << std::endl;
+            File.close();
+            return false;
+        }
+        const uint64_t size = File.size();
+        for (uint32_t i = 0; i < header->Levels; i++)
+        {
+            const BakedTextureLevel &l = levels()[i];
+            // dataSize() and the upload take the levels as one run, level i + 1 starting where level i ends
+            if (l.Width > MAX_SIZE || l.Height > MAX_SIZE || (i > 0 && l.Offset != levels()[i - 1].Offset + levels()[i - 1].Size))
+            {
+                std::cout << "ERROR::BAKED_TEXTURE::INVALID_FILE: " << path << std::endl;
+                File.close();
+                return false;
+            }
+            if (l.Offset > size || l.Size > size - l.Offset || l.Size < static_cast<uint64_t>(l.Width) * l.Height * header->Components)
+            {
+                std::cout << "ERROR::BAKED_TEXTURE::TRUNCATED_FILE: " << path << std::endl;
+                File.close();
+                return false;
+            }
+        }
+        Valid = true;
+        return true;
+    }
+
+    void close()
+    {
+        File.close();
+        Valid = false;
+    }
+
+    bool isOpen() const
+    {
+        return Valid;
+    }
+
+    const BakedTextureHeader &header() const
+    {
+        return *reinterpret_cast<const BakedTextureHeader *>(File.data());
+    }
+
+    const BakedTextureLevel &level(uint32_t index) const
+    {
+        return levels()[index];
+    }
+
+    const unsigned char *pixels(uint32_t index) const
+    {
+        return File.data() + levels()[index].Offset;
+    }
+
+    // every level back to back, [pixels(0), pixels(0) + dataSize()) covers the whole mip chain
+    uint64_t dataSize() const
+    {
+        const BakedTextureLevel &last = levels()[header().Levels - 1];
+        return last.Offset + last.Size - levels()[0].Offset;
+    }
+
+    // read the whole mip chain in now, so that copying it out later does not wait on the disk
+    void prefault() const
+    {
+        File.prefault(static_cast<size_t>(levels()[0].Offset), static_cast<size_t>(dataSize()));
+    }
+
+private:
+    static const uint32_t MAX_SIZE = 1 << 16; // per side, keeps Width * Height * Components in 64 bits
+
+    MappedFile File;
+    bool Valid = false;
+
+    const BakedTextureLevel *levels() const
+    {
+        return reinterpret_cast<const BakedTextureLevel *>(File.data() + sizeof(BakedTextureHeader));
+    }
+};
+#endif
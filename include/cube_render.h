@@ -4,6 +4,7 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <shader.h>
+#include <gl_state.h>
 
 #include <string>
 
@@ -60,9 +61,9 @@ public:
     {
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
-        glBindVertexArray(VAO);
+        GLState::get().bindVertexArray(VAO);
 
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        GLState::get().bindArrayBuffer(VBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
@@ -71,18 +72,16 @@ public:
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
         glEnableVertexAttribArray(2);
-        glBindVertexArray(0);
+        GLState::get().bindVertexArray(0);
     }
 
-    void draw(Shader &shader, glm::mat4 &model, glm::mat4 &view, glm::mat4 &projection)
+    // projection and view come from the FrameData uniform block
+    void draw(Shader &shader, glm::mat4 &model)
     {
         shader.use();
-        shader.setMat4("projection", projection);
-        shader.setMat4("view", view);
-        shader.setMat4("model", model);
-        glBindVertexArray(VAO);
+        shader.setMat4("model"_u, model);
+        GLState::get().bindVertexArray(VAO);
         glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
     }
 
 private:
@@ -0,0 +1,126 @@
+#ifndef FONT_MANAGER_H
+#define FONT_MANAGER_H
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <mapped_file.h>
+
+#include <iostream>
+#include <string>
+
+// the Arial family shipped in resources/fonts
+enum FontStyle
+{
+    FONT_REGULAR,
+    FONT_BOLD,
+    FONT_ITALIC,
+    FONT_BOLD_ITALIC,
+    FONT_NARROW,
+    FONT_NARROW_BOLD,
+    FONT_NARROW_ITALIC,
+    FONT_NARROW_BOLD_ITALIC,
+    FONT_BLACK,
+    FONT_STYLE_COUNT
+};
+
+// Process wide owner of the FreeType library and the font faces. A style's file is mapped and its
+// face opened with FT_New_Memory_Face the first time the style is asked for, so unused styles cost
+// nothing. Faces stay open until exit and are shared by every UiText; each UiText creates its own
+// FT_Size per pixel size, so sharing a face never changes another text object's size.
+// Worker threads must not use these faces, they open their own from the shared mapping instead.
+class FontManager
+{
+public:
+    static FontManager &get()
+    {
+        static FontManager manager;
+        return manager;
+    }
+
+    ~FontManager()
+    {
+        for (Entry &entry : Entries)
+        {
+            if (entry.Face)
+                FT_Done_Face(entry.Face);
+        }
+        if (Library)
+            FT_Done_FreeType(Library);
+    }
+
+    FontManager(const FontManager &) = delete;
+    FontManager &operator=(const FontManager &) = delete;
+
+    static std::string path(FontStyle style)
+    {
+        static const char *const files[FONT_STYLE_COUNT] = {
+            "arial.ttf", "arialbd.ttf", "ariali.ttf", "arialbi.ttf",
+            "ARIALN.TTF", "ARIALNB.TTF", "ARIALNI.TTF", "ARIALNBI.TTF",
+            "ariblk.ttf"};
+        return std::string("resources/fonts/") + files[style];
+    }
+
+    // nullptr when FreeType could not be initialised
+    FT_Library library()
+    {
+        if (!LibraryTried)
+        {
+            LibraryTried = true;
+            if (FT_Init_FreeType(&Library))
+            {
+                std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+                Library = nullptr;
+            }
+        }
+        return Library;
+    }
+
+    // the mapped font file, nullptr when it could not be mapped. Valid until exit
+    const MappedFile *file(FontStyle style)
+    {
+        Entry &entry = Entries[style];
+        if (!entry.MapTried)
+        {
+            entry.MapTried = true;
+            entry.File.open(path(style));
+        }
+        return entry.File.isOpen() ? &entry.File : nullptr;
+    }
+
+    // nullptr when the face could not be opened, the failure is only reported once
+    FT_Face face(FontStyle style)
+    {
+        Entry &entry = Entries[style];
+        if (entry.FaceTried)
+            return entry.Face;
+        entry.FaceTried = true;
+        const MappedFile *mapped = file(style);
+        if (!mapped || !library())
+            return nullptr;
+        if (FT_New_Memory_Face(Library, mapped->data(), static_cast<FT_Long>(mapped->size()), 0, &entry.Face))
+        {
+            std::cout << "ERROR::FREETYPE: Failed to load font " << path(style) << std::endl;
+            entry.Face = nullptr;
+        }
+        return entry.Face;
+    }
+
+private:
+    struct Entry
+    {
+        MappedFile File;
+        FT_Face Face = nullptr;
+        bool MapTried = false;
+        bool FaceTried = false;
+    };
+
+    FT_Library Library = nullptr;
+    bool LibraryTried = false;
+    Entry Entries[FONT_STYLE_COUNT];
+
+    FontManager()
+    {
+    }
+};
+#endif
@@ -0,0 +1,84 @@
+#ifndef FRAME_DATA_H
+#define FRAME_DATA_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <gl_state.h>
+
+#include <vector>
+#include <cstring>
+
+// uniform buffer binding point of the FrameData block, every Shader binds its block here after linking
+const GLuint FRAME_DATA_BINDING = 0;
+
+// CPU mirror of the std140 FrameData block declared in resources/shaders/*.vs:
+//   layout (std140) uniform FrameData { mat4 projection; mat4 view; mat4 viewProj; vec3 cameraPos; float time; };
+struct FrameData
+{
+    glm::mat4 Projection;
+    glm::mat4 View;
+    glm::mat4 ViewProj;
+    glm::vec3 CameraPos;
+    float Time;
+};
+static_assert(sizeof(FrameData) == 208, "FrameData must match the std140 layout of the FrameData block");
+
+// Owns the uniform buffer holding the per-frame camera data. It keeps one record for the 3D scene and one
+// for screen space (UI), both uploaded once per frame; switching between them is a glBindBufferRange
+class FrameUniforms
+{
+public:
+    enum Space
+    {
+        SCENE = 0,
+        SCREEN = 1,
+    };
+
+    FrameUniforms()
+    {
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        Stride = (sizeof(FrameData) + alignment - 1) / alignment * alignment;
+        Staging.resize(Stride * 2);
+
+        glGenBuffers(1, &UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferData(GL_UNIFORM_BUFFER, Staging.size(), NULL, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // upload both records with a single buffer update, call once per frame before drawing
+    void update(const FrameData &scene, const FrameData &screen)
+    {
+        std::memcpy(&Staging[SCENE * Stride], &scene, sizeof(FrameData));
+        std::memcpy(&Staging[SCREEN * Stride], &screen, sizeof(FrameData));
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferData(GL_UNIFORM_BUFFER, Staging.size(), NULL, GL_DYNAMIC_DRAW); // orphan last frame's storage
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, Staging.size(), Staging.data());
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // make the given record visible to every program through FRAME_DATA_BINDING
+    void bind(Space space)
+    {
+        GLState::get().bindUniformBufferRange(FRAME_DATA_BINDING, UBO, space * Stride, sizeof(FrameData));
+    }
+
+    static FrameData make(const glm::mat4 &projection, const glm::mat4 &view, const glm::vec3 &cameraPos, float time)
+    {
+        FrameData data;
+        data.Projection = projection;
+        data.View = view;
+        data.ViewProj = projection * view;
+        data.CameraPos = cameraPos;
+        data.Time = time;
+        return data;
+    }
+
+private:
+    unsigned int UBO;
+    size_t Stride;
+    std::vector<unsigned char> Staging;
+};
+#endif
@@ -0,0 +1,200 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+// Thin cache of the GL binding/enable state the renderers touch every frame. All render classes bind
+// through it so that a call which would not change anything never reaches the driver.
+// Cached values start out unknown, so the first call for each piece of state is always issued.
+class GLState
+{
+public:
+    // counts of calls forwarded to GL vs. dropped because the state already matched
+    struct Stats
+    {
+        unsigned long Issued;
+        unsigned long Skipped;
+    };
+
+    static const GLuint MAX_TEXTURE_UNITS = 16;
+
+    static GLState &get()
+    {
+        static GLState state;
+        return state;
+    }
+
+    void useProgram(GLuint program)
+    {
+        if (filter(Program, program))
+            glUseProgram(program);
+    }
+
+    void bindVertexArray(GLuint vao)
+    {
+        if (filter(VertexArray, vao))
+            glBindVertexArray(vao);
+    }
+
+    void bindArrayBuffer(GLuint buffer)
+    {
+        if (filter(ArrayBuffer, buffer))
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    }
+
+    // indexed uniform buffer binding, e.g. the FrameData block
+    void bindUniformBufferRange(GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+    {
+        if (index < MAX_UNIFORM_BINDINGS)
+        {
+            UniformRange &range = UniformRanges[index];
+            if (range.Buffer == buffer && range.Offset == offset && range.Size == size)
+            {
+                CurrentStats.Skipped++;
+                return;
+            }
+            range = UniformRange{buffer, offset, size};
+        }
+        CurrentStats.Issued++;
+        glBindBufferRange(GL_UNIFORM_BUFFER, index, buffer, offset, size);
+    }
+
+    // unit is the texture unit index (0 for GL_TEXTURE0)
+    void activeTexture(GLuint unit)
+    {
+        if (filter(ActiveUnit, unit))
+            glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    // binds texture to unit, only switching the active unit when the binding actually changes
+    void bindTexture(GLuint unit, GLenum target, GLuint texture)
+    {
+        int slot = targetIndex(target);
+        if (unit >= MAX_TEXTURE_UNITS || slot < 0)
+        {
+            activeTexture(unit);
+            CurrentStats.Issued++;
+            glBindTexture(target, texture);
+            return;
+        }
+        if (!filter(Textures[unit][slot], texture))
+            return;
+        activeTexture(unit);
+        glBindTexture(target, texture);
+    }
+
+    // bindTexture for calls that act on the active unit's binding (glTexSubImage2D, glTexParameteri,
+    // glTexBuffer...): a filtered bind leaves whatever unit was last active, so make unit active as well
+    void bindTextureForUpdate(GLuint unit, GLenum target, GLuint texture)
+    {
+        bindTexture(unit, target, texture);
+        activeTexture(unit);
+    }
+
+    void deleteTexture(GLuint texture)
+    {
+        for (GLuint unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+            for (GLuint &bound : Textures[unit])
+                if (bound == texture)
+                    bound = 0;
+        glDeleteTextures(1, &texture);
+    }
+
+    // deleting a bound object resets that binding to 0 in GL, mirror that so a recycled name is bound again
+    void deleteVertexArray(GLuint vao)
+    {
+        if (VertexArray == vao)
+            VertexArray = 0;
+        glDeleteVertexArrays(1, &vao);
+    }
+
+    void deleteBuffer(GLuint buffer)
+    {
+        if (ArrayBuffer == buffer)
+            ArrayBuffer = 0;
+        for (UniformRange &range : UniformRanges)
+            if (range.Buffer == buffer)
+                range = UniformRange{UNKNOWN, -1, -1};
+        glDeleteBuffers(1, &buffer);
+    }
+
+    void setBlend(bool enabled) { setCapability(GL_BLEND, Blend, enabled); }
+    void setDepthTest(bool enabled) { setCapability(GL_DEPTH_TEST, DepthTest, enabled); }
+    void setCullFace(bool enabled) { setCapability(GL_CULL_FACE, CullFace, enabled); }
+
+    const Stats &stats() const { return CurrentStats; }
+    void resetStats() { CurrentStats = Stats{0, 0}; }
+
+private:
+    static const GLuint UNKNOWN = ~0u;
+    static const GLuint MAX_UNIFORM_BINDINGS = 8;
+    static const int TRACKED_TARGETS = 2;
+
+    struct UniformRange
+    {
+        GLuint Buffer;
+        GLintptr Offset;
+        GLsizeiptr Size;
+    };
+
+    GLuint Program = UNKNOWN;
+    GLuint VertexArray = UNKNOWN;
+    GLuint ArrayBuffer = UNKNOWN;
+    GLuint ActiveUnit = UNKNOWN;
+    GLuint Textures[MAX_TEXTURE_UNITS][TRACKED_TARGETS];
+    UniformRange UniformRanges[MAX_UNIFORM_BINDINGS];
+    GLuint Blend = UNKNOWN;
+    GLuint DepthTest = UNKNOWN;
+    GLuint CullFace = UNKNOWN;
+    Stats CurrentStats = Stats{0, 0};
+
+    GLState()
+    {
+        for (GLuint unit = 0; unit < MAX_TEXTURE_UNITS; unit++)
+            for (GLuint &bound : Textures[unit])
+                bound = UNKNOWN;
+        for (UniformRange &range : UniformRanges)
+            range = UniformRange{UNKNOWN, -1, -1};
+    }
+    GLState(const GLState &) = delete;
+    GLState &operator=(const GLState &) = delete;
+
+    // returns true when the call has to be issued, and records the new value
+    bool filter(GLuint &cached, GLuint value)
+    {
+        if (cached == value)
+        {
+            CurrentStats.Skipped++;
+            return false;
+        }
+        cached = value;
+        CurrentStats.Issued++;
+        return true;
+    }
+
+    void setCapability(GLenum cap, GLuint &cached, bool enabled)
+    {
+        if (!filter(cached, enabled ? 1 : 0))
+            return;
+        if (enabled)
+            glEnable(cap);
+        else
+            glDisable(cap);
+    }
+
+    static int targetIndex(GLenum target)
+    {
+        switch (target)
+        {
+        case GL_TEXTURE_2D:
+            return 0;
+        case GL_TEXTURE_BUFFER:
+            return 1;
+        default:
+            return -1;
+        }
+    }
+};
+#endif
@@ -0,0 +1,266 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <gl_state.h>
+
+#include <algorithm>
+#include <vector>
+
+// Single R8 texture holding the coverage bitmaps of many glyphs, shared by every face and size.
+// The texture is swizzled to (1, 1, 1, r) so shaders get the glyph coverage in alpha.
+// Glyphs are placed on shelves: full width rows whose height is the glyph's height rounded up to a
+// size class, so a 12 px and a 96 px glyph never share a row and a freed slot is only ever reused by a
+// glyph of about its own height. Slots handed back with release() merge with free neighbours on their
+// shelf, and a shelf that empties gives its rows back, so space freed by small glyphs can hold large
+// ones. Blocks from addBlock() (a baked atlas) take rows of their own; their glyph slots are reused
+// whole, by glyphs of the same size class.
+class GlyphAtlas
+{
+public:
+    GLuint TextureID;
+    int Width, Height;
+    // bumped by clear(), when every glyph loses its slot. A single release() does not bump it, whoever
+    // keeps UVs must make sure the glyphs behind them stay (UiText::pinGlyphs)
+    unsigned int Generation;
+
+    GlyphAtlas(int width = 1024, int height = 1024) : Width(width), Height(height), Generation(0)
+    {
+        FreeRows.push_back(glm::ivec2(0, height));
+        std::vector<unsigned char> clear(width * height, 0);
+        glGenTextures(1, &TextureID);
+        GLState::get().bindTextureForUpdate(0, GL_TEXTURE_2D, TextureID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, clear.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        GLint swizzle[] = {GL_ONE, GL_ONE, GL_ONE, GL_RED};
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+
+    // copy an 8-bit coverage bitmap (rows top to bottom, pitch bytes apart) into the atlas.
+    // rect receives the reserved slot for release(), uv receives (u0, v0, u1, v1) with v0 at the top row.
+    // returns false when no shelf, free row or released block slot has room
+    bool add(int w, int h, const unsigned char *pixels, int pitch, glm::ivec4 &rect, glm::vec4 &uv)
+    {
+        if (w <= 0 || h <= 0)
+        {
+            rect = glm::ivec4(0);
+            uv = glm::vec4(0.0f);
+            return true;
+        }
+        if (!allocate(w + PADDING, h + PADDING, rect))
+            return false;
+
+        GLState::get().bindTextureForUpdate(0, GL_TEXTURE_2D, TextureID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, w, h, GL_RED, GL_UNSIGNED_BYTE, pixels);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+        uv = glm::vec4(
+            static_cast<float>(rect.x) / Width,
+            static_cast<float>(rect.y) / Height,
+            static_cast<float>(rect.x + w) / Width,
+            static_cast<float>(rect.y + h) / Height);
+        return true;
+    }
+
+    // reserve a w x h region and fill it with an already packed, already padded block of glyphs,
+    // e.g. a baked atlas. origin receives the region's top left corner
+    bool addBlock(int w, int h, const unsigned char *pixels, int pitch, glm::ivec2 &origin)
+    {
+        if (w <= 0 || h <= 0)
+        {
+            origin = glm::ivec2(0);
+            return true;
+        }
+        if (w > Width || !takeRows(h, origin.y))
+            return false;
+        origin.x = 0;
+        Blocks.push_back(glm::ivec2(origin.y, h));
+        GLState::get().bindTextureForUpdate(0, GL_TEXTURE_2D, TextureID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, origin.x, origin.y, w, h, GL_RED, GL_UNSIGNED_BYTE, pixels);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        return true;
+    }
+
+    // give a slot returned by add() back for reuse. The slot is cleared so a smaller glyph placed
+    // in it later still sees empty padding texels
+    void release(const glm::ivec4 &rect)
+    {
+        if (rect.z <= 0 || rect.w <= 0)
+            return;
+        std::vector<unsigned char> clear(rect.z * rect.w, 0);
+        GLState::get().bindTextureForUpdate(0, GL_TEXTURE_2D, TextureID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.z, rect.w, GL_RED, GL_UNSIGNED_BYTE, clear.data());
+
+        for (const glm::ivec2 &block : Blocks)
+        {
+            if (rect.y >= block.x && rect.y < block.x + block.y)
+            {
+                BlockSlots.push_back(rect);
+                return;
+            }
+        }
+        // glyphs sit at the top of their shelf
+        for (size_t i = 0; i < Shelves.size(); i++)
+        {
+            Shelf &shelf = Shelves[i];
+            if (shelf.Y != rect.y)
+                continue;
+            giveBack(shelf.Free, glm::ivec2(rect.x, rect.z));
+            if (shelf.Free.size() == 1 && shelf.Free[0].x == 0 && shelf.Free[0].y == Width)
+            {
+                giveBack(FreeRows, glm::ivec2(shelf.Y, shelf.Height));
+                Shelves.erase(Shelves.begin() + i);
+            }
+            return;
+        }
+    }
+
+    // texels in free rows, free shelf spans and released block slots. More than a glyph needs while
+    // add() fails means the space is fragmented rather than used up
+    size_t freeArea() const
+    {
+        size_t area = 0;
+        for (const glm::ivec2 &rows : FreeRows)
+            area += static_cast<size_t>(rows.y) * Width;
+        for (const Shelf &shelf : Shelves)
+            for (const glm::ivec2 &span : shelf.Free)
+                area += static_cast<size_t>(span.y) * shelf.Height;
+        for (const glm::ivec4 &slot : BlockSlots)
+            area += static_cast<size_t>(slot.z) * slot.w;
+        return area;
+    }
+
+    // padded size of a w x h glyph
+    static size_t slotArea(int w, int h)
+    {
+        return static_cast<size_t>(w + PADDING) * (h + PADDING);
+    }
+
+    // forget every glyph and block and clear the texture, for when the free space is too fragmented
+    void clear()
+    {
+        Shelves.clear();
+        Blocks.clear();
+        BlockSlots.clear();
+        FreeRows.assign(1, glm::ivec2(0, Height));
+        std::vector<unsigned char> clear(static_cast<size_t>(Width) * Height, 0);
+        GLState::get().bindTextureForUpdate(0, GL_TEXTURE_2D, TextureID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, Width, Height, GL_RED, GL_UNSIGNED_BYTE, clear.data());
+        Generation++;
+    }
+
+private:
+    // empty texels kept right/below every glyph so linear filtering never picks up a neighbour
+    static const int PADDING = 1;
+
+    struct Shelf
+    {
+        int Y, Height;                  // Height is a size class, see shelfHeight()
+        std::vector<glm::ivec2> Free;   // (x, width) spans, sorted and merged
+    };
+
+    std::vector<Shelf> Shelves;
+    std::vector<glm::ivec2> FreeRows;   // (y, height) rows in no shelf or block, sorted and merged
+    std::vector<glm::ivec2> Blocks;     // (y, height) rows taken by addBlock()
+    std::vector<glm::ivec4> BlockSlots; // released (x, y, w, h) slots inside blocks, padding included
+
+    // glyph heights rounded up in steps of about an eighth, so a shelf wastes little height
+    static int shelfHeight(int h)
+    {
+        int step = 4;
+        while (step * 8 < h)
+            step *= 2;
+        return (h + step - 1) / step * step;
+    }
+
+    bool allocate(int w, int h, glm::ivec4 &rect)
+    {
+        if (w > Width)
+            return false;
+        int height = shelfHeight(h);
+        for (Shelf &shelf : Shelves)
+        {
+            if (shelf.Height == height && takeSpan(shelf.Free, w, rect.x))
+            {
+                rect = glm::ivec4(rect.x, shelf.Y, w, h);
+                return true;
+            }
+        }
+        int y;
+        if (takeRows(height, y))
+        {
+            Shelves.push_back(Shelf{y, height, std::vector<glm::ivec2>(1, glm::ivec2(w, Width - w))});
+            if (w == Width)
+                Shelves.back().Free.clear();
+            rect = glm::ivec4(0, y, w, h);
+            return true;
+        }
+        // smallest released block slot of the same size class
+        int best = -1;
+        for (size_t i = 0; i < BlockSlots.size(); i++)
+        {
+            const glm::ivec4 &slot = BlockSlots[i];
+            if (slot.z >= w && slot.w >= h && shelfHeight(slot.w) == height &&
+                (best < 0 || slot.z * slot.w < BlockSlots[best].z * BlockSlots[best].w))
+                best = static_cast<int>(i);
+        }
+        if (best < 0)
+            return false;
+        rect = BlockSlots[best];
+        BlockSlots[best] = BlockSlots.back();
+        BlockSlots.pop_back();
+        return true;
+    }
+
+    // first fit from a sorted list of (start, length) spans
+    static bool takeSpan(std::vector<glm::ivec2> &spans, int length, int &start)
+    {
+        for (size_t i = 0; i < spans.size(); i++)
+        {
+            if (spans[i].y < length)
+                continue;
+            start = spans[i].x;
+            spans[i].x += length;
+            spans[i].y -= length;
+            if (spans[i].y == 0)
+                spans.erase(spans.begin() + i);
+            return true;
+        }
+        return false;
+    }
+
+    bool takeRows(int height, int &y)
+    {
+        return takeSpan(FreeRows, height, y);
+    }
+
+    // insert a (start, length) span and merge it with the spans it touches
+    static void giveBack(std::vector<glm::ivec2> &spans, glm::ivec2 span)
+    {
+        auto next = std::lower_bound(spans.begin(), spans.end(), span, [](const glm::ivec2 &a, const glm::ivec2 &b) { return a.x < b.x; });
+        next = spans.insert(next, span);
+        if (next + 1 != spans.end() && next->x + next->y == (next + 1)->x)
+        {
+            next->y += (next + 1)->y;
+            spans.erase(next + 1);
+        }
+        if (next != spans.begin() && (next - 1)->x + (next - 1)->y == next->x)
+        {
+            (next - 1)->y += next->y;
+            spans.erase(next);
+        }
+    }
+};
+#endif
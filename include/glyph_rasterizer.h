@@ -0,0 +1,144 @@
+#ifndef GLYPH_RASTERIZER_H
+#define GLYPH_RASTERIZER_H
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_MODULE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// one glyph bitmap produced off the GL thread, rows top to bottom and tightly packed
+struct RasterizedGlyph
+{
+    uint32_t Codepoint;
+    bool Loaded;
+    int Width, Height;
+    int Left, Top;
+    long Advance; // 1/64 pixel
+    std::vector<unsigned char> Pixels;
+};
+
+struct RasterizerOptions
+{
+    std::string FontPath;
+    int PixelSize;
+    bool Sdf;
+    unsigned int Spread; // only used with Sdf
+    // font file already in memory (e.g. a FontManager mapping), opened instead of FontPath when set.
+    // must stay valid until rasterize() returns
+    const unsigned char *FontData = nullptr;
+    size_t FontSize = 0;
+};
+
+// Rasterizes a set of codepoints with FreeType on worker threads. FreeType objects are not thread safe,
+// so every worker opens its own FT_Library and FT_Face, from the file or from a shared read-only mapping.
+// Workers pull codepoints from a shared atomic counter and write straight into their result slot,
+// which is the staging area handed back to the GL thread for the atlas upload.
+class GlyphRasterizer
+{
+public:
+    // threads == 0 picks std::thread::hardware_concurrency()
+    static std::vector<RasterizedGlyph> rasterize(const RasterizerOptions &options, const std::vector<uint32_t> &codepoints, unsigned int threads = 0)
+    {
+        std::vector<RasterizedGlyph> results(codepoints.size());
+        if (codepoints.empty())
+            return results;
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = static_cast<unsigned int>(std::min<size_t>(threads, codepoints.size()));
+
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            FT_Library ft;
+            FT_Face face;
+            if (!open(options, ft, face))
+                return;
+            for (size_t i = next++; i < codepoints.size(); i = next++)
+                render(options, face, codepoints[i], results[i]);
+            FT_Done_Face(face);
+            FT_Done_FreeType(ft);
+        };
+
+        std::vector<std::thread> pool;
+        for (unsigned int i = 1; i < threads; i++)
+            pool.emplace_back(worker);
+        worker(); // the calling thread works too
+        for (std::thread &thread : pool)
+            thread.join();
+        return results;
+    }
+
+    static bool open(const RasterizerOptions &options, FT_Library &ft, FT_Face &face)
+    {
+        if (FT_Init_FreeType(&ft))
+        {
+            std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+            return false;
+        }
+        FT_Error error = options.FontData
+                             ? FT_New_Memory_Face(ft, options.FontData, static_cast<FT_Long>(options.FontSize), 0, &face)
+                             : FT_New_Face(ft, options.FontPath.c_str(), 0, &face);
+        if (error)
+        {
+            std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
+            FT_Done_FreeType(ft);
+            return false;
+        }
+        FT_Set_Pixel_Sizes(face, 0, options.PixelSize);
+        if (options.Sdf)
+        {
+            FT_UInt spread = options.Spread;
+            FT_Property_Set(ft, "sdf", "spread", &spread);
+        }
+        return true;
+    }
+
+    // render one codepoint with face into out, the face must have been set up by open()
+    static void render(const RasterizerOptions &options, FT_Face face, uint32_t codepoint, RasterizedGlyph &out)
+    {
+        out.Codepoint = codepoint;
+        out.Loaded = false;
+        FT_Error error;
+        if (options.Sdf)
+        {
+            error = FT_Load_Char(face, codepoint, FT_LOAD_DEFAULT);
+            // the sdf renderer rejects empty outlines, blanks like the space keep an empty bitmap and their advance
+            if (!error && face->glyph->format == FT_GLYPH_FORMAT_OUTLINE && face->glyph->outline.n_contours == 0)
+            {
+                out.Loaded = true;
+                out.Width = out.Height = 0;
+                out.Left = out.Top = 0;
+                out.Advance = face->glyph->advance.x;
+                out.Pixels.clear();
+                return;
+            }
+            if (!error)
+                error = FT_Render_Glyph(face->glyph, FT_RENDER_MODE_SDF);
+        }
+        else
+            error = FT_Load_Char(face, codepoint, FT_LOAD_RENDER);
+        if (error)
+            return;
+
+        const FT_GlyphSlot slot = face->glyph;
+        out.Loaded = true;
+        out.Width = slot->bitmap.width;
+        out.Height = slot->bitmap.rows;
+        out.Left = slot->bitmap_left;
+        out.Top = slot->bitmap_top;
+        out.Advance = slot->advance.x;
+        out.Pixels.resize(static_cast<size_t>(out.Width) * out.Height);
+        for (int row = 0; row < out.Height; row++)
+        {
+            const unsigned char *src = slot->bitmap.buffer + row * slot->bitmap.pitch;
+            std::copy(src, src + out.Width, out.Pixels.begin() + static_cast<size_t>(row) * out.Width);
+        }
+    }
+};
+#endif
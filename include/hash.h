@@ -0,0 +1,31 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+// FNV-1a hashes. constexpr so that string literals can be hashed at compile time
+// ------------------------------------------------------------------------
+constexpr uint32_t fnv1a32(const char *data, size_t length, uint32_t hash = 2166136261u)
+{
+    for (size_t i = 0; i < length; i++)
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * 16777619u;
+    return hash;
+}
+
+constexpr uint32_t fnv1a32(const char *str)
+{
+    uint32_t hash = 2166136261u;
+    for (; *str; str++)
+        hash = (hash ^ static_cast<uint8_t>(*str)) * 16777619u;
+    return hash;
+}
+
+inline uint64_t fnv1a64(const void *data, size_t length, uint64_t hash = 14695981039346656037ull)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < length; i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+}
+#endif
@@ -0,0 +1,134 @@
+#ifndef IMAGE_LOADER_H
+#define IMAGE_LOADER_H
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+struct ImageInfo
+{
+    int Width = 0, Height = 0;
+    int Components = 0; // of the decoded pixels, the file's own unless a count was asked for
+
+    size_t size() const
+    {
+        return static_cast<size_t>(Width) * Height * Components;
+    }
+};
+
+// Decodes images held in memory (typically a MappedFile) straight into a buffer the caller owns, such
+// as a mapped pixel unpack buffer or a mip chain's level 0, instead of a fresh stb_image allocation
+// that then has to be copied. src/stb_image.cpp routes stb_image's allocations through allocate(),
+// which hands out the caller's buffer for the one request that has the exact size of the final image.
+// When that request is some intermediate buffer rather than the result (a decoder that converts
+// formats in several steps), the result ends up in a normal allocation; decode() notices and copies,
+// so the pixels are the same either way.
+class ImageLoader
+{
+public:
+    // dimensions and component count from the header alone, nothing is decoded.
+    // components != 0 asks for that many components per pixel, as stbi_load does
+    static bool info(const unsigned char *data, size_t size, ImageInfo &out, int components = 0)
+    {
+        int width, height, comp;
+        if (!stbi_info_from_memory(data, static_cast<int>(size), &width, &height, &comp))
+            return false;
+        out.Width = width;
+        out.Height = height;
+        out.Components = components ? components : comp;
+        return true;
+    }
+
+    // decode into dst, which must hold at least info().size() bytes. fills out when given
+    static bool decode(const unsigned char *data, size_t size, unsigned char *dst, size_t capacity, int components = 0, ImageInfo *out = nullptr)
+    {
+        ImageInfo image;
+        if (!info(data, size, image, components))
+        {
+            std::cout << "ERROR::IMAGE_LOADER::UNKNOWN_FORMAT: " << stbi_failure_reason() << std::endl;
+            return false;
+        }
+        if (image.size() > capacity)
+        {
+            std::cout << "ERROR::IMAGE_LOADER::BUFFER_TOO_SMALL: " << image.size() << " bytes needed, " << capacity << " given" << std::endl;
+            return false;
+        }
+
+        Target &target = current();
+        target.Data = dst;
+        target.Size = image.size();
+        target.Taken = false;
+        int width, height, comp;
+        unsigned char *pixels = stbi_load_from_memory(data, static_cast<int>(size), &width, &height, &comp, components);
+        target.Data = nullptr;
+        if (!pixels)
+        {
+            std::cout << "ERROR::IMAGE_LOADER::DECODE_FAILED: " << stbi_failure_reason() << std::endl;
+            return false;
+        }
+        if (pixels != dst)
+        {
+            std::memcpy(dst, pixels, image.size());
+            stbi_image_free(pixels);
+        }
+        if (out)
+            *out = image;
+        return true;
+    }
+
+    // stb_image's STBI_MALLOC, STBI_REALLOC and STBI_FREE, see src/stb_image.cpp
+    static void *allocate(size_t size)
+    {
+        Target &target = current();
+        if (target.Data && !target.Taken && size == target.Size)
+        {
+            target.Taken = true;
+            return target.Data;
+        }
+        return std::malloc(size);
+    }
+
+    static void *reallocate(void *pointer, size_t size)
+    {
+        if (pointer && isTarget(pointer))
+        {
+            // stb_image never grows its output, but keep the caller's buffer out of realloc regardless
+            void *moved = std::malloc(size);
+            if (moved)
+                std::memcpy(moved, pointer, std::min(size, current().Size));
+            return moved;
+        }
+        return std::realloc(pointer, size);
+    }
+
+    static void release(void *pointer)
+    {
+        if (!isTarget(pointer))
+            std::free(pointer);
+    }
+
+private:
+    // the caller's buffer for the decode running on this thread
+    struct Target
+    {
+        unsigned char *Data = nullptr;
+        size_t Size = 0;
+        bool Taken = false;
+    };
+
+    static Target &current()
+    {
+        static thread_local Target target;
+        return target;
+    }
+
+    static bool isTarget(const void *pointer)
+    {
+        return pointer && pointer == current().Data;
+    }
+};
+#endif
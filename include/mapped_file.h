@@ -0,0 +1,178 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+// Read-only memory mapping of a whole file. Pages are loaded by the OS on first touch, so
+// opening a large file is cheap and only the parts actually read cost I/O.
+class MappedFile
+{
+public:
+    MappedFile() : Data(nullptr), Size(0)
+    {
+    }
+
+    explicit MappedFile(const std::string &path) : MappedFile()
+    {
+        open(path);
+    }
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) : Data(other.Data), Size(other.Size), Opened(other.Opened)
+    {
+#ifdef _WIN32
+        Mapping = other.Mapping;
+        other.Mapping = NULL;
+#endif
+        other.Data = nullptr;
+        other.Size = 0;
+        other.Opened = false;
+    }
+
+    // maps path, replacing any previous mapping. Empty files map to an open file of size 0
+    bool open(const std::string &path)
+    {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            std::cout << "ERROR::MAPPED_FILE::OPEN_FAILED: " << path << std::endl;
+            return false;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size))
+        {
+            CloseHandle(file);
+            std::cout << "ERROR::MAPPED_FILE::STAT_FAILED: " << path << std::endl;
+            return false;
+        }
+        Size = static_cast<size_t>(size.QuadPart);
+        if (Size > 0)
+        {
+            Mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            Data = Mapping ? static_cast<const unsigned char *>(MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+        }
+        CloseHandle(file);
+#else
+        int file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0)
+        {
+            std::cout << "ERROR::MAPPED_FILE::OPEN_FAILED: " << path << std::endl;
+            return false;
+        }
+        struct stat info;
+        if (fstat(file, &info) != 0)
+        {
+            ::close(file);
+            std::cout << "ERROR::MAPPED_FILE::STAT_FAILED: " << path << std::endl;
+            return false;
+        }
+        Size = static_cast<size_t>(info.st_size);
+        if (Size > 0)
+        {
+            void *mapped = mmap(nullptr, Size, PROT_READ, MAP_PRIVATE, file, 0);
+            Data = mapped == MAP_FAILED ? nullptr : static_cast<const unsigned char *>(mapped);
+        }
+        ::close(file); // the mapping keeps its own reference
+#endif
+        if (Size > 0 && !Data)
+        {
+            close();
+            std::cout << "ERROR::MAPPED_FILE::MAP_FAILED: " << path << std::endl;
+            return false;
+        }
+        Opened = true;
+        return true;
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (Data)
+            UnmapViewOfFile(Data);
+        if (Mapping)
+            CloseHandle(Mapping);
+        Mapping = NULL;
+#else
+        if (Data)
+            munmap(const_cast<unsigned char *>(Data), Size);
+#endif
+        Data = nullptr;
+        Size = 0;
+        Opened = false;
+    }
+
+    bool isOpen() const
+    {
+        return Opened;
+    }
+
+    const unsigned char *data() const
+    {
+        return Data;
+    }
+
+    size_t size() const
+    {
+        return Size;
+    }
+
+    // fault [offset, offset + size) in now, for a thread that should do the disk I/O so that a later
+    // reader (the render thread) does not
+    void prefault(size_t offset, size_t size) const
+    {
+        if (offset >= Size || size == 0)
+            return;
+        size = std::min(size, Size - offset);
+#ifdef _WIN32
+#if _WIN32_WINNT >= 0x0602
+        WIN32_MEMORY_RANGE_ENTRY range = {const_cast<unsigned char *>(Data) + offset, size};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+        // one read-ahead request for the whole range instead of a fault per page
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t start = offset - offset % page;
+        madvise(const_cast<unsigned char *>(Data) + start, offset + size - start, MADV_WILLNEED);
+#endif
+        // the advice is only a hint, touching a byte per page makes sure every page is mapped in
+        volatile unsigned char sink = 0;
+        for (size_t i = offset; i < offset + size; i += TOUCH_STRIDE)
+            sink = sink + Data[i];
+        sink = sink + Data[offset + size - 1];
+    }
+
+private:
+    static const size_t TOUCH_STRIDE = 4096; // the smallest page size in use, touching more often is harmless
+
+    const unsigned char *Data;
+    size_t Size;
+    bool Opened = false;
+#ifdef _WIN32
+    HANDLE Mapping = NULL;
+#endif
+};
+#endif
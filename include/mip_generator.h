@@ -0,0 +1,565 @@
+#ifndef MIP_GENERATOR_H
+#define MIP_GENERATOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MIP_GENERATOR_SSE2
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MIP_GENERATOR_AVX2
+#endif
+
+enum MipFilter
+{
+    MIP_BOX,     // 2x2 average, what glGenerateMipmap does on most drivers
+    MIP_KAISER,  // Kaiser windowed sinc, sharper than box with little ringing
+    MIP_LANCZOS, // Lanczos-3, the sharpest, can ring around hard edges
+};
+
+struct MipOptions
+{
+    MipFilter Filter = MIP_BOX;
+    // filter color channels in linear light, for textures sampled as GL_SRGB8(_ALPHA8). alpha stays as is
+    bool Srgb = false;
+    // when above 0, scale the alpha of every level so the share of texels with alpha above the cutoff
+    // stays what it is in level 0. keeps alpha tested cutouts (foliage, fences) from fading with distance
+    float AlphaCutoff = 0.0f;
+    // threads per level, each takes a band of rows. 0 picks std::thread::hardware_concurrency()
+    unsigned int Threads = 1;
+    // false runs the plain scalar loops, the reference the SSE/AVX paths are checked against
+    bool Vectorize = true;
+};
+
+struct MipLevel
+{
+    int Width, Height;
+    size_t Offset; // into MipChain::Data
+    size_t Size;   // bytes
+};
+
+// every level of an image back to back in one allocation, so it can be copied or written in one go
+struct MipChain
+{
+    int Components = 0;
+    std::vector<MipLevel> Levels; // level 0 first
+    std::vector<unsigned char> Data;
+
+    const unsigned char *pixels(size_t level) const
+    {
+        return Data.data() + Levels[level].Offset;
+    }
+
+    bool empty() const
+    {
+        return Levels.empty();
+    }
+};
+
+// Builds mip chains on the CPU, 8 bits per channel, rows tightly packed. Used offline by the texture
+// baker and on TextureLoader worker threads, so the render thread never runs glGenerateMipmap.
+// Box filtering without sRGB stays in 8 bit integers; the windowed sinc filters and sRGB run separably
+// in float, carrying the float image from level to level so rounding does not pile up down the chain.
+// The inner loops have SSE2 (and AVX2 when compiled with it) versions for RGBA, the common case, other
+// layouts take the scalar loops.
+class MipGenerator
+{
+public:
+    // number of levels down to 1x1, like glGenerateMipmap
+    static int levelCount(int width, int height)
+    {
+        int levels = 1;
+        while (width > 1 || height > 1)
+        {
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+            levels++;
+        }
+        return levels;
+    }
+
+    // halve src with a 2x2 box filter into dst, which must hold max(1, w / 2) * max(1, h / 2) texels.
+    // an odd last row or column is folded into its neighbour by clamping. scalar reference
+    static void box(const unsigned char *src, int width, int height, int components, unsigned char *dst)
+    {
+        boxRows(src, width, height, components, dst, 0, std::max(1, height / 2), false);
+    }
+
+    // every level from level 0 (copied) down to 1x1
+    static MipChain chain(const unsigned char *pixels, int width, int height, int components, const MipOptions &options = MipOptions())
+    {
+        MipChain mips = layout(width, height, components);
+        std::memcpy(mips.Data.data(), pixels, mips.Levels[0].Size);
+        generate(mips, options);
+        return mips;
+    }
+
+    // an allocated chain with every level placed but nothing filtered yet. level 0 can be written in
+    // place (e.g. decoded into by ImageLoader) before generate() fills in the rest
+    static MipChain layout(int width, int height, int components)
+    {
+        MipChain mips;
+        mips.Components = components;
+        size_t offset = 0;
+        for (int i = 0, levels = levelCount(width, height), w = width, h = height; i < levels; i++)
+        {
+            size_t size = static_cast<size_t>(w) * h * components;
+            mips.Levels.push_back(MipLevel{w, h, offset, size});
+            offset += size;
+            w = std::max(1, w / 2);
+            h = std::max(1, h / 2);
+        }
+        mips.Data.resize(offset);
+        return mips;
+    }
+
+    // filter every level from level 0 of a chain made by layout()
+    static void generate(MipChain &mips, const MipOptions &options = MipOptions())
+    {
+        int components = mips.Components;
+        unsigned int threads = options.Threads ? options.Threads : std::max(1u, std::thread::hardware_concurrency());
+        if (options.Filter == MIP_BOX && !options.Srgb)
+        {
+            for (size_t i = 1; i < mips.Levels.size(); i++)
+            {
+                const MipLevel &src = mips.Levels[i - 1];
+                const unsigned char *in = mips.pixels(i - 1);
+                unsigned char *out = mips.Data.data() + mips.Levels[i].Offset;
+                parallelRows(mips.Levels[i].Height, threads, [&](int begin, int end) {
+                    boxRows(in, src.Width, src.Height, components, out, begin, end, options.Vectorize);
+                });
+            }
+        }
+        else
+            filterChain(mips, options, threads);
+
+        if (options.AlphaCutoff > 0.0f && (components == 2 || components == 4))
+            preserveCoverage(mips, options.AlphaCutoff);
+    }
+
+private:
+    // bands smaller than this are not worth a thread
+    static const int MIN_ROWS_PER_THREAD = 32;
+
+    // the taps of a separable filter along one axis: for output texel x, the source texels
+    // Index[x * Taps + k] (already clamped to the edge) weighted by Weights[x * Taps + k]
+    struct Kernel
+    {
+        int Taps;
+        std::vector<int> Index;
+        std::vector<float> Weights;
+    };
+
+    // call work(begin, end) for bands of [0, rows) on up to threads threads, the calling thread works too
+    template <typename Work>
+    static void parallelRows(int rows, unsigned int threads, Work work)
+    {
+        threads = std::min(threads, static_cast<unsigned int>(std::max(1, rows / MIN_ROWS_PER_THREAD)));
+        if (threads <= 1)
+        {
+            work(0, rows);
+            return;
+        }
+        int band = (rows + threads - 1) / threads;
+        std::vector<std::thread> pool;
+        for (int begin = band; begin < rows; begin += band)
+            pool.emplace_back(work, begin, std::min(rows, begin + band));
+        work(0, band);
+        for (std::thread &thread : pool)
+            thread.join();
+    }
+
+    static void boxRows(const unsigned char *src, int width, int height, int components, unsigned char *dst, int begin, int end, bool vectorize)
+    {
+        int dstWidth = std::max(1, width / 2);
+        for (int y = begin; y < end; y++)
+        {
+            const unsigned char *row0 = src + static_cast<size_t>(std::min(y * 2, height - 1)) * width * components;
+            const unsigned char *row1 = src + static_cast<size_t>(std::min(y * 2 + 1, height - 1)) * width * components;
+            unsigned char *out = dst + static_cast<size_t>(y) * dstWidth * components;
+            int x = 0;
+            if (vectorize && components == 4)
+                x = boxRowRgba(row0, row1, out, dstWidth, width);
+            for (; x < dstWidth; x++)
+            {
+                int x0 = std::min(x * 2, width - 1) * components, x1 = std::min(x * 2 + 1, width - 1) * components;
+                for (int c = 0; c < components; c++)
+                    out[x * components + c] = static_cast<unsigned char>((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+            }
+        }
+    }
+
+    // box filter as many RGBA texels of a row as the vector loops cover, returns where the scalar tail starts.
+    // the two rows are summed in 16 bits, then neighbouring texels are paired up, so the result is exactly
+    // the scalar (a + b + c + d + 2) >> 2
+    static int boxRowRgba(const unsigned char *row0, const unsigned char *row1, unsigned char *out, int dstWidth, int width)
+    {
+        int x = 0;
+#ifdef MIP_GENERATOR_AVX2
+        const __m256i zero8 = _mm256_setzero_si256(), two8 = _mm256_set1_epi16(2);
+        for (; x + 4 <= dstWidth && x * 2 + 8 <= width; x += 4)
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row0 + x * 8));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row1 + x * 8));
+            // per 128 bit lane: lo holds texels 0,1 (4,5), hi holds texels 2,3 (6,7)
+            __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero8), _mm256_unpacklo_epi8(b, zero8));
+            __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero8), _mm256_unpackhi_epi8(b, zero8));
+            __m256i sum = _mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi), _mm256_unpackhi_epi64(lo, hi));
+            sum = _mm256_srli_epi16(_mm256_add_epi16(sum, two8), 2);
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(sum, sum), 0x08);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x * 4), _mm256_castsi256_si128(packed));
+        }
+#endif
+#ifdef MIP_GENERATOR_SSE2
+        const __m128i zero = _mm_setzero_si128(), two = _mm_set1_epi16(2);
+        for (; x + 2 <= dstWidth && x * 2 + 4 <= width; x += 2)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 8));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 8));
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)); // texels 0, 1
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)); // texels 2, 3
+            __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi)); // 0 + 1, 2 + 3
+            sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(out + x * 4), _mm_packus_epi16(sum, sum));
+        }
+#else
+        (void)row0, (void)row1, (void)out, (void)dstWidth, (void)width;
+#endif
+        return x;
+    }
+
+    static float sinc(float x)
+    {
+        if (std::fabs(x) < 1e-6f)
+            return 1.0f;
+        x *= 3.14159265f;
+        return std::sin(x) / x;
+    }
+
+    // zeroth order modified Bessel function of the first kind, for the Kaiser window
+    static float besselI0(float x)
+    {
+        float sum = 1.0f, term = 1.0f;
+        for (int k = 1; k < 32 && term > sum * 1e-8f; k++)
+        {
+            term *= (x / (2.0f * k)) * (x / (2.0f * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // radius of the filter in destination texels
+    static float support(MipFilter filter)
+    {
+        return filter == MIP_BOX ? 0.5f : 3.0f;
+    }
+
+    // filter weight at t destination texels from the sample centre
+    static float weight(MipFilter filter, float t)
+    {
+        float r = support(filter);
+        if (std::fabs(t) >= r)
+            return filter == MIP_BOX && std::fabs(t) == r ? 0.5f : 0.0f;
+        switch (filter)
+        {
+        case MIP_KAISER:
+        {
+            const float alpha = 4.0f; // same window shape NVTT uses for its Kaiser filter
+            float s = t / r;
+            return sinc(t) * besselI0(alpha * std::sqrt(1.0f - s * s)) / besselI0(alpha);
+        }
+        case MIP_LANCZOS:
+            return sinc(t) * sinc(t / r);
+        default:
+            return 1.0f;
+        }
+    }
+
+    // the taps that shrink srcSize texels to dstSize along one axis, normalized, zero weights trimmed
+    static Kernel kernel(MipFilter filter, int srcSize, int dstSize)
+    {
+        float scale = static_cast<float>(srcSize) / dstSize;
+        float radius = support(filter) * scale;
+        std::vector<std::vector<std::pair<int, float>>> taps(dstSize);
+        Kernel k;
+        k.Taps = 1;
+        for (int x = 0; x < dstSize; x++)
+        {
+            float center = (x + 0.5f) * scale, sum = 0.0f;
+            for (int s = static_cast<int>(std::floor(center - radius)); s <= static_cast<int>(std::ceil(center + radius)); s++)
+            {
+                float w = weight(filter, (s + 0.5f - center) / scale);
+                if (w == 0.0f)
+                    continue;
+                taps[x].push_back(std::make_pair(std::min(std::max(s, 0), srcSize - 1), w));
+                sum += w;
+            }
+            for (std::pair<int, float> &tap : taps[x])
+                tap.second /= sum;
+            k.Taps = std::max(k.Taps, static_cast<int>(taps[x].size()));
+        }
+        // pad to a fixed tap count with zero weights on a valid index so the loops need no bounds
+        k.Index.resize(static_cast<size_t>(dstSize) * k.Taps);
+        k.Weights.resize(k.Index.size());
+        for (int x = 0; x < dstSize; x++)
+            for (int t = 0; t < k.Taps; t++)
+            {
+                bool real = t < static_cast<int>(taps[x].size());
+                k.Index[x * k.Taps + t] = real ? taps[x][t].first : taps[x].empty() ? 0 : taps[x][0].first;
+                k.Weights[x * k.Taps + t] = real ? taps[x][t].second : 0.0f;
+            }
+        return k;
+    }
+
+    static float srgbToLinear(float c)
+    {
+        return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    static float linearToSrgb(float c)
+    {
+        return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+    }
+
+    // byte to [0, 1] float, decoded from sRGB when srgb is set
+    static const float *decodeTable(bool srgb)
+    {
+        struct Tables
+        {
+            float Linear[256], Srgb[256];
+            Tables()
+            {
+                for (int i = 0; i < 256; i++)
+                {
+                    Linear[i] = i / 255.0f;
+                    Srgb[i] = srgbToLinear(i / 255.0f);
+                }
+            }
+        };
+        static const Tables tables;
+        return srgb ? tables.Srgb : tables.Linear;
+    }
+
+    // linear [0, 1] to sRGB encoded bytes, indexed by value * (SRGB_ENCODE_SIZE - 1), fine enough that
+    // the steep part of the curve near black still resolves every byte
+    static const int SRGB_ENCODE_SIZE = 1 << 14;
+
+    static const unsigned char *encodeTable()
+    {
+        struct Table
+        {
+            unsigned char Values[SRGB_ENCODE_SIZE];
+            Table()
+            {
+                for (int i = 0; i < SRGB_ENCODE_SIZE; i++)
+                    Values[i] = static_cast<unsigned char>(linearToSrgb(i / float(SRGB_ENCODE_SIZE - 1)) * 255.0f + 0.5f);
+            }
+        };
+        static const Table table;
+        return table.Values;
+    }
+
+    static bool isAlpha(int channel, int components)
+    {
+        return (components == 2 || components == 4) && channel == components - 1;
+    }
+
+    // separable filtering in float: rows into a dstWidth x srcHeight temporary, then columns into the level
+    static void filterChain(MipChain &mips, const MipOptions &options, unsigned int threads)
+    {
+        int components = mips.Components;
+        const float *linear = decodeTable(false), *decode = decodeTable(options.Srgb);
+        std::vector<float> image(mips.Levels[0].Size), next, temp;
+        const unsigned char *pixels = mips.pixels(0);
+        for (size_t i = 0; i < image.size(); i += components)
+            for (int c = 0; c < components; c++)
+                image[i + c] = isAlpha(c, components) ? linear[pixels[i + c]] : decode[pixels[i + c]];
+
+        for (size_t i = 1; i < mips.Levels.size(); i++)
+        {
+            const MipLevel &src = mips.Levels[i - 1], &dst = mips.Levels[i];
+            Kernel horizontal = kernel(options.Filter, src.Width, dst.Width);
+            Kernel vertical = kernel(options.Filter, src.Height, dst.Height);
+            size_t srcRow = static_cast<size_t>(src.Width) * components, dstRow = static_cast<size_t>(dst.Width) * components;
+            temp.resize(dstRow * src.Height);
+            next.resize(dstRow * dst.Height);
+            unsigned char *out = mips.Data.data() + dst.Offset;
+
+            parallelRows(src.Height, threads, [&](int begin, int end) {
+                for (int y = begin; y < end; y++)
+                    filterRow(&image[y * srcRow], &temp[y * dstRow], components, horizontal, dst.Width, options.Vectorize);
+            });
+            parallelRows(dst.Height, threads, [&](int begin, int end) {
+                for (int y = begin; y < end; y++)
+                {
+                    filterColumn(temp.data(), dstRow, &next[y * dstRow], vertical, y, options.Vectorize);
+                    quantizeRow(&next[y * dstRow], out + y * dstRow, dstRow, components, options.Srgb, options.Vectorize);
+                }
+            });
+            image.swap(next);
+        }
+    }
+
+    static void filterRow(const float *src, float *dst, int components, const Kernel &k, int dstWidth, bool vectorize)
+    {
+#ifdef MIP_GENERATOR_SSE2
+        // one RGBA texel per vector
+        if (vectorize && components == 4)
+        {
+            for (int x = 0; x < dstWidth; x++)
+            {
+                const int *index = &k.Index[x * k.Taps];
+                const float *weights = &k.Weights[x * k.Taps];
+                __m128 sum = _mm_setzero_ps();
+                for (int t = 0; t < k.Taps; t++)
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + index[t] * 4), _mm_set1_ps(weights[t])));
+                _mm_storeu_ps(dst + x * 4, sum);
+            }
+            return;
+        }
+#else
+        (void)vectorize;
+#endif
+        for (int x = 0; x < dstWidth; x++)
+        {
+            const int *index = &k.Index[x * k.Taps];
+            const float *weights = &k.Weights[x * k.Taps];
+            for (int c = 0; c < components; c++)
+            {
+                float sum = 0.0f;
+                for (int t = 0; t < k.Taps; t++)
+                    sum += src[index[t] * components + c] * weights[t];
+                dst[x * components + c] = sum;
+            }
+        }
+    }
+
+    // output row y of the vertical pass, a weighted sum of whole rows of temp
+    static void filterColumn(const float *temp, size_t rowSize, float *dst, const Kernel &k, int y, bool vectorize)
+    {
+        const int *index = &k.Index[y * k.Taps];
+        const float *weights = &k.Weights[y * k.Taps];
+        size_t i = 0;
+        if (vectorize)
+        {
+#ifdef MIP_GENERATOR_AVX2
+            for (; i + 8 <= rowSize; i += 8)
+            {
+                __m256 sum = _mm256_setzero_ps();
+                for (int t = 0; t < k.Taps; t++)
+                    sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(temp + index[t] * rowSize + i), _mm256_set1_ps(weights[t])));
+                _mm256_storeu_ps(dst + i, sum);
+            }
+#endif
+#ifdef MIP_GENERATOR_SSE2
+            for (; i + 4 <= rowSize; i += 4)
+            {
+                __m128 sum = _mm_setzero_ps();
+                for (int t = 0; t < k.Taps; t++)
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(temp + index[t] * rowSize + i), _mm_set1_ps(weights[t])));
+                _mm_storeu_ps(dst + i, sum);
+            }
+#endif
+        }
+        for (; i < rowSize; i++)
+        {
+            float sum = 0.0f;
+            for (int t = 0; t < k.Taps; t++)
+                sum += temp[index[t] * rowSize + i] * weights[t];
+            dst[i] = sum;
+        }
+    }
+
+    static void quantizeRow(const float *src, unsigned char *dst, size_t size, int components, bool srgb, bool vectorize)
+    {
+        if (srgb)
+        {
+            const unsigned char *encode = encodeTable();
+            for (size_t i = 0; i < size; i += components)
+                for (int c = 0; c < components; c++)
+                {
+                    float v = std::min(std::max(src[i + c], 0.0f), 1.0f);
+                    dst[i + c] = isAlpha(c, components) ? static_cast<unsigned char>(v * 255.0f + 0.5f)
+                                                        : encode[static_cast<int>(v * (SRGB_ENCODE_SIZE - 1) + 0.5f)];
+                }
+            return;
+        }
+        size_t i = 0;
+#ifdef MIP_GENERATOR_SSE2
+        if (vectorize)
+        {
+            const __m128 scale = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f), low = _mm_setzero_ps();
+            for (; i + 4 <= size; i += 4)
+            {
+                __m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale), half);
+                __m128i bytes = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(v, low), scale));
+                bytes = _mm_packs_epi32(bytes, bytes);
+                int packed = _mm_cvtsi128_si32(_mm_packus_epi16(bytes, bytes));
+                std::memcpy(dst + i, &packed, 4);
+            }
+        }
+#else
+        (void)vectorize;
+#endif
+        for (; i < size; i++)
+            dst[i] = static_cast<unsigned char>(std::min(std::max(src[i] * 255.0f + 0.5f, 0.0f), 255.0f));
+    }
+
+    // share of texels whose alpha, multiplied by scale, is above cutoff (0-255), from an alpha histogram
+    static float coverage(const size_t *histogram, size_t texels, float scale, float cutoff)
+    {
+        size_t covered = 0;
+        for (int alpha = 0; alpha < 256; alpha++)
+            covered += alpha * scale > cutoff ? histogram[alpha] : 0;
+        return static_cast<float>(covered) / texels;
+    }
+
+    static void alphaHistogram(const unsigned char *pixels, size_t texels, int components, size_t *histogram)
+    {
+        std::fill(histogram, histogram + 256, 0);
+        for (size_t i = 0; i < texels; i++)
+            histogram[pixels[i * components + components - 1]]++;
+    }
+
+    static void preserveCoverage(MipChain &mips, float alphaCutoff)
+    {
+        int components = mips.Components;
+        float cutoff = alphaCutoff * 255.0f;
+        size_t histogram[256];
+        alphaHistogram(mips.pixels(0), mips.Levels[0].Size / components, components, histogram);
+        float target = coverage(histogram, mips.Levels[0].Size / components, 1.0f, cutoff);
+        for (size_t i = 1; i < mips.Levels.size(); i++)
+        {
+            unsigned char *pixels = mips.Data.data() + mips.Levels[i].Offset;
+            size_t texels = mips.Levels[i].Size / components;
+            alphaHistogram(pixels, texels, components, histogram);
+            // coverage grows with the scale, bisect for the one that matches level 0
+            float low = 0.0f, high = 4.0f;
+            for (int step = 0; step < 16; step++)
+            {
+                float mid = (low + high) * 0.5f;
+                if (coverage(histogram, texels, mid, cutoff) < target)
+                    low = mid;
+                else
+                    high = mid;
+            }
+            unsigned char scaled[256];
+            for (int alpha = 0; alpha < 256; alpha++)
+                scaled[alpha] = static_cast<unsigned char>(std::min(alpha * high + 0.5f, 255.0f));
+            for (size_t t = 0; t < texels; t++)
+            {
+                unsigned char &alpha = pixels[t * components + components - 1];
+                alpha = scaled[alpha];
+            }
+        }
+    }
+};
+#endif
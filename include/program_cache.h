@@ -0,0 +1,152 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <hash.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary).
+// Entries are keyed on the shader sources and the driver's vendor/renderer/version strings,
+// so a driver update or an edited shader simply misses the cache and recompiles.
+class ProgramCache
+{
+public:
+    static const char *directory()
+    {
+        return "shader_cache";
+    }
+
+    static bool supported()
+    {
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_get_program_binary)
+        if (!glProgramBinary || !glGetProgramBinary || !glProgramParameteri)
+            return false;
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
+#else
+        return false;
+#endif
+    }
+
+    static uint64_t key(const std::string &vertexCode, const std::string &fragmentCode, const std::string &geometryCode)
+    {
+        uint64_t hash = fnv1a64(vertexCode.data(), vertexCode.size());
+        hash = fnv1a64(fragmentCode.data(), fragmentCode.size(), hash);
+        hash = fnv1a64(geometryCode.data(), geometryCode.size(), hash);
+        const GLenum driverStrings[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+        for (GLenum name : driverStrings)
+        {
+            const char *str = reinterpret_cast<const char *>(glGetString(name));
+            if (str)
+                hash = fnv1a64(str, std::char_traits<char>::length(str), hash);
+        }
+        return hash;
+    }
+
+    // call before glLinkProgram so that the driver keeps the binary around for store()
+    static void prepare(GLuint program)
+    {
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_get_program_binary)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+    }
+
+    // try to initialize program from the cache, returns false on a miss or when the driver rejects the binary
+    static bool load(GLuint program, uint64_t key)
+    {
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_get_program_binary)
+        std::ifstream file(path(key), std::ios::binary);
+        if (!file)
+            return false;
+        Header header;
+        if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) || header.Magic != MAGIC || header.Key != key)
+            return false;
+        std::vector<char> binary(header.Length);
+        if (!file.read(binary.data(), binary.size()))
+            return false;
+
+        glProgramBinary(program, header.Format, binary.data(), static_cast<GLsizei>(binary.size()));
+        GLint success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        return success == GL_TRUE;
+#else
+        return false;
+#endif
+    }
+
+    // program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+    static void store(GLuint program, uint64_t key)
+    {
+#if defined(GL_VERSION_4_1) || defined(GL_ARB_get_program_binary)
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+        std::vector<char> binary(length);
+        Header header;
+        header.Magic = MAGIC;
+        header.Key = key;
+        glGetProgramBinary(program, length, NULL, &header.Format, binary.data());
+        header.Length = static_cast<uint32_t>(length);
+
+        makeDirectory(directory());
+        // write to a temporary file first so a crash never leaves a truncated entry behind
+        std::string target = path(key);
+        std::string temp = target + ".tmp";
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                std::cout << "ERROR::PROGRAM_CACHE::FILE_NOT_WRITABLE: " << temp << std::endl;
+                return;
+            }
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(binary.data(), binary.size());
+        }
+        std::remove(target.c_str());
+        std::rename(temp.c_str(), target.c_str());
+#endif
+    }
+
+private:
+    static const uint32_t MAGIC = 0x42504c47; // "GLPB"
+
+    struct Header
+    {
+        uint32_t Magic;
+        GLenum Format;
+        uint64_t Key;
+        uint32_t Length;
+    };
+
+    static std::string path(uint64_t key)
+    {
+        std::stringstream name;
+        name << directory() << "/" << std::hex << key << ".bin";
+        return name.str();
+    }
+
+    static void makeDirectory(const char *dir)
+    {
+#ifdef _WIN32
+        _mkdir(dir);
+#else
+        mkdir(dir, 0755);
+#endif
+    }
+};
+#endif
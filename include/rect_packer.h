@@ -0,0 +1,101 @@
+#ifndef RECT_PACKER_H
+#define RECT_PACKER_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+// Skyline bottom-left rectangle packer. Keeps the top edge of the packed area as a list of horizontal
+// segments and places every rectangle at the lowest position it fits, preferring the narrowest segment.
+class RectPacker
+{
+public:
+    RectPacker(int width, int height) : Width(width), Height(height)
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        Skyline.clear();
+        Skyline.push_back(Node{0, 0, Width});
+    }
+
+    // find room for a w x h rectangle, returns false when the area is full
+    bool pack(int w, int h, glm::ivec2 &position)
+    {
+        int bestIndex = -1, bestY = std::numeric_limits<int>::max(), bestWidth = std::numeric_limits<int>::max();
+        for (size_t i = 0; i < Skyline.size(); i++)
+        {
+            int y = fit(i, w, h);
+            if (y < 0)
+                continue;
+            if (y + h < bestY || (y + h == bestY && Skyline[i].Width < bestWidth))
+            {
+                bestIndex = static_cast<int>(i);
+                bestY = y + h;
+                bestWidth = Skyline[i].Width;
+            }
+        }
+        if (bestIndex < 0)
+            return false;
+
+        position = glm::ivec2(Skyline[bestIndex].X, bestY - h);
+        Skyline.insert(Skyline.begin() + bestIndex, Node{position.x, bestY, w});
+
+        // the new segment shadows the start of the ones after it
+        for (size_t i = bestIndex + 1; i < Skyline.size();)
+        {
+            const Node &prev = Skyline[i - 1];
+            int overlap = prev.X + prev.Width - Skyline[i].X;
+            if (overlap <= 0)
+                break;
+            Skyline[i].X += overlap;
+            Skyline[i].Width -= overlap;
+            if (Skyline[i].Width > 0)
+                break;
+            Skyline.erase(Skyline.begin() + i);
+        }
+        // merge neighbours at the same height
+        for (size_t i = 0; i + 1 < Skyline.size();)
+        {
+            if (Skyline[i].Y == Skyline[i + 1].Y)
+            {
+                Skyline[i].Width += Skyline[i + 1].Width;
+                Skyline.erase(Skyline.begin() + i + 1);
+            }
+            else
+                i++;
+        }
+        return true;
+    }
+
+private:
+    struct Node
+    {
+        int X, Y, Width;
+    };
+
+    int Width, Height;
+    std::vector<Node> Skyline;
+
+    // y at which a w x h rectangle starting at segment index would rest, -1 if it does not fit
+    int fit(size_t index, int w, int h) const
+    {
+        int x = Skyline[index].X;
+        if (x + w > Width)
+            return -1;
+        int y = Skyline[index].Y;
+        for (int widthLeft = w; widthLeft > 0; index++)
+        {
+            y = std::max(y, Skyline[index].Y);
+            if (y + h > Height)
+                return -1;
+            widthLeft -= Skyline[index].Width;
+        }
+        return y;
+    }
+};
+#endif
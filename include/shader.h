@@ -4,11 +4,36 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <hash.h>
+#include <program_cache.h>
+#include <frame_data.h>
+#include <gl_state.h>
+
 #include <string>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
+// uniform name whose hash is computed at compile time: shader.setMat4("model"_u, model)
+struct UniformName
+{
+    uint32_t Hash;
+    const char *Str;
+    size_t Length;
+};
+
+constexpr UniformName operator"" _u(const char *str, size_t length)
+{
+    return UniformName{fnv1a32(str, length), str, length};
+}
+
+// uniform location resolved once through Shader::uniform(); -1 when the program has no such active uniform
+struct UniformHandle
+{
+    GLint Location = -1;
+};
+
 class Shader
 {
 public:
@@ -57,9 +82,19 @@ public:
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
         }
+        // 2. try the program binary cache before compiling anything
+        ID = glCreateProgram();
+        bool binaryCache = ProgramCache::supported();
+        uint64_t cacheKey = binaryCache ? ProgramCache::key(vertexCode, fragmentCode, geometryCode) : 0;
+        if (binaryCache && ProgramCache::load(ID, cacheKey))
+        {
+            loadActiveUniforms();
+            bindFrameData();
+            return;
+        }
         const char *vShaderCode = vertexCode.c_str();
         const char *fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
+        // 3. compile shaders
         unsigned int vertex, fragment;
         // vertex shader
         vertex = glCreateShader(GL_VERTEX_SHADER);
@@ -82,13 +117,17 @@ public:
             checkCompileErrors(geometry, "GEOMETRY");
         }
         // shader Program
-        ID = glCreateProgram();
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
         if (geometryPath != nullptr)
             glAttachShader(ID, geometry);
+        if (binaryCache)
+            ProgramCache::prepare(ID);
         glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
+        if (checkCompileErrors(ID, "PROGRAM") && binaryCache)
+            ProgramCache::store(ID, cacheKey);
+        loadActiveUniforms();
+        bindFrameData();
         // delete the shaders as they're linked into our program now and no longer necessery
         glDeleteShader(vertex);
         glDeleteShader(fragment);
@@ -99,71 +138,189 @@ public:
     // ------------------------------------------------------------------------
     void use()
     {
-        glUseProgram(ID);
+        GLState::get().useProgram(ID);
+    }
+    // resolve a uniform once; keep the handle and use it on the per-frame path
+    // ------------------------------------------------------------------------
+    UniformHandle uniform(UniformName name) const
+    {
+        return UniformHandle{findLocation(name.Hash, name.Str, name.Length)};
+    }
+    UniformHandle uniform(const std::string &name) const
+    {
+        return UniformHandle{findLocation(fnv1a32(name.c_str(), name.size()), name.c_str(), name.size())};
     }
     // utility uniform functions
     // ------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const
+    void setBool(UniformHandle handle, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        glUniform1i(handle.Location, (int)value);
     }
+    void setBool(UniformName name, bool value) const { setBool(uniform(name), value); }
+    void setBool(const std::string &name, bool value) const { setBool(uniform(name), value); }
     // ------------------------------------------------------------------------
-    void setInt(const std::string &name, int value) const
+    void setInt(UniformHandle handle, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1i(handle.Location, value);
     }
+    void setInt(UniformName name, int value) const { setInt(uniform(name), value); }
+    void setInt(const std::string &name, int value) const { setInt(uniform(name), value); }
     // ------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value) const
+    void setFloat(UniformHandle handle, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1f(handle.Location, value);
     }
+    void setFloat(UniformName name, float value) const { setFloat(uniform(name), value); }
+    void setFloat(const std::string &name, float value) const { setFloat(uniform(name), value); }
     // ------------------------------------------------------------------------
-    void setVec2(const std::string &name, const glm::vec2 &value) const
+    void setVec2(UniformHandle handle, const glm::vec2 &value) const
     {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform2fv(handle.Location, 1, &value[0]);
     }
-    void setVec2(const std::string &name, float x, float y) const
+    void setVec2(UniformHandle handle, float x, float y) const
     {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        glUniform2f(handle.Location, x, y);
     }
+    void setVec2(UniformName name, const glm::vec2 &value) const { setVec2(uniform(name), value); }
+    void setVec2(UniformName name, float x, float y) const { setVec2(uniform(name), x, y); }
+    void setVec2(const std::string &name, const glm::vec2 &value) const { setVec2(uniform(name), value); }
+    void setVec2(const std::string &name, float x, float y) const { setVec2(uniform(name), x, y); }
     // ------------------------------------------------------------------------
-    void setVec3(const std::string &name, const glm::vec3 &value) const
+    void setVec3(UniformHandle handle, const glm::vec3 &value) const
     {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform3fv(handle.Location, 1, &value[0]);
     }
-    void setVec3(const std::string &name, float x, float y, float z) const
+    void setVec3(UniformHandle handle, float x, float y, float z) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        glUniform3f(handle.Location, x, y, z);
     }
+    void setVec3(UniformName name, const glm::vec3 &value) const { setVec3(uniform(name), value); }
+    void setVec3(UniformName name, float x, float y, float z) const { setVec3(uniform(name), x, y, z); }
+    void setVec3(const std::string &name, const glm::vec3 &value) const { setVec3(uniform(name), value); }
+    void setVec3(const std::string &name, float x, float y, float z) const { setVec3(uniform(name), x, y, z); }
     // ------------------------------------------------------------------------
-    void setVec4(const std::string &name, const glm::vec4 &value) const
+    void setVec4(UniformHandle handle, const glm::vec4 &value) const
     {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform4fv(handle.Location, 1, &value[0]);
     }
-    void setVec4(const std::string &name, float x, float y, float z, float w)
+    void setVec4(UniformHandle handle, float x, float y, float z, float w) const
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        glUniform4f(handle.Location, x, y, z, w);
     }
+    void setVec4(UniformName name, const glm::vec4 &value) const { setVec4(uniform(name), value); }
+    void setVec4(UniformName name, float x, float y, float z, float w) const { setVec4(uniform(name), x, y, z, w); }
+    void setVec4(const std::string &name, const glm::vec4 &value) const { setVec4(uniform(name), value); }
+    void setVec4(const std::string &name, float x, float y, float z, float w) const { setVec4(uniform(name), x, y, z, w); }
     // ------------------------------------------------------------------------
-    void setMat2(const std::string &name, const glm::mat2 &mat) const
+    void setMat2(UniformHandle handle, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(handle.Location, 1, GL_FALSE, &mat[0][0]);
     }
+    void setMat2(UniformName name, const glm::mat2 &mat) const { setMat2(uniform(name), mat); }
+    void setMat2(const std::string &name, const glm::mat2 &mat) const { setMat2(uniform(name), mat); }
     // ------------------------------------------------------------------------
-    void setMat3(const std::string &name, const glm::mat3 &mat) const
+    void setMat3(UniformHandle handle, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix3fv(handle.Location, 1, GL_FALSE, &mat[0][0]);
     }
+    void setMat3(UniformName name, const glm::mat3 &mat) const { setMat3(uniform(name), mat); }
+    void setMat3(const std::string &name, const glm::mat3 &mat) const { setMat3(uniform(name), mat); }
     // ------------------------------------------------------------------------
-    void setMat4(const std::string &name, const glm::mat4 &mat) const
+    void setMat4(UniformHandle handle, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(handle.Location, 1, GL_FALSE, &mat[0][0]);
     }
+    void setMat4(UniformName name, const glm::mat4 &mat) const { setMat4(uniform(name), mat); }
+    void setMat4(const std::string &name, const glm::mat4 &mat) const { setMat4(uniform(name), mat); }
 
 private:
+    struct UniformSlot
+    {
+        uint32_t Hash;
+        GLint Location;
+        uint32_t NameOffset, NameLength; // in UniformNames
+        bool Used;
+    };
+    // open addressing table (power of two size, linear probing) filled once after linking. Slots keep
+    // their name so that two names with the same hash never get each other's location
+    std::vector<UniformSlot> Uniforms;
+    std::string UniformNames;
+
+    // enumerate the program's active uniforms so that no glGetUniformLocation happens afterwards
+    // ------------------------------------------------------------------------
+    void loadActiveUniforms()
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        size_t capacity = 8;
+        while (capacity < static_cast<size_t>(count) * 4) // room for the "[0]" aliases
+            capacity <<= 1;
+        Uniforms.assign(capacity, UniformSlot{0, -1, 0, 0, false});
+        UniformNames.clear();
+
+        std::vector<GLchar> name(maxLength > 0 ? maxLength : 1);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, i, static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+            GLint location = glGetUniformLocation(ID, name.data());
+            if (location < 0) // uniform block members have no location
+                continue;
+            insertUniform(name.data(), length, location);
+            // arrays are reported as "name[0]", also make them reachable as "name"
+            if (length > 3 && std::string(name.data() + length - 3, 3) == "[0]")
+                insertUniform(name.data(), length - 3, location);
+        }
+    }
+    // point the program's FrameData block (if it declares one) at the shared per-frame uniform buffer
+    // ------------------------------------------------------------------------
+    void bindFrameData()
+    {
+        GLuint index = glGetUniformBlockIndex(ID, "FrameData");
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, index, FRAME_DATA_BINDING);
+    }
+    // ------------------------------------------------------------------------
+    void insertUniform(const char *name, size_t length, GLint location)
+    {
+        uint32_t hash = fnv1a32(name, length);
+        size_t mask = Uniforms.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask)
+        {
+            UniformSlot &slot = Uniforms[i];
+            if (!slot.Used)
+            {
+                slot = UniformSlot{hash, location, static_cast<uint32_t>(UniformNames.size()), static_cast<uint32_t>(length), true};
+                UniformNames.append(name, length);
+                return;
+            }
+            if (matches(slot, hash, name, length))
+                return;
+        }
+    }
+    // ------------------------------------------------------------------------
+    GLint findLocation(uint32_t hash, const char *name, size_t length) const
+    {
+        size_t mask = Uniforms.size() - 1;
+        for (size_t i = hash & mask; Uniforms[i].Used; i = (i + 1) & mask)
+        {
+            if (matches(Uniforms[i], hash, name, length))
+                return Uniforms[i].Location;
+        }
+        return -1;
+    }
+    // the hash settles almost every probe, the name only has to be compared once it matches
+    bool matches(const UniformSlot &slot, uint32_t hash, const char *name, size_t length) const
+    {
+        return slot.Hash == hash && slot.NameLength == length && UniformNames.compare(slot.NameOffset, length, name, length) == 0;
+    }
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
-    void checkCompileErrors(GLuint shader, std::string type)
+    bool checkCompileErrors(GLuint shader, std::string type)
     {
         GLint success;
         GLchar infoLog[1024];
@@ -187,6 +344,7 @@ private:
                           << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
             }
         }
+        return success == GL_TRUE;
     }
 };
 #endif
\ No newline at end of file
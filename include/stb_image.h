@@ -271,6 +271,13 @@ RECENT REVISION HISTORY:
 // you have issues compiling it, you can disable it entirely by
 // defining STBI_NO_SIMD.
 //
+// Define STBI_FAST_PNG for a faster PNG decoder (local addition, the
+// build turns it on with the FAST_PNG option): the zlib inflate reads
+// 64 bits at a time, decodes up to two literals per table lookup and
+// copies matches 8/16 bytes at a time, and 8-bit RGB/RGBA rows are
+// unfiltered with SSE2. Output is identical to the plain code, which is
+// still used near the end of the data and for every other format.
+//
 // ===========================================================================
 //
 // HDR image support   (disable by defining STBI_NO_HDR)
@@ -4672,6 +4679,24 @@ static int stbi__zbuild_huffman(stbi__zhuffman *z, const stbi_uc *sizelist, int
     return 1;
 }
 
+#ifdef STBI_FAST_PNG
+// wide lookup tables for the fast inflate loop, indexed by the next bits of the stream.
+// literal/length entries:  bits 0-7 code bits, 8-10 kind, 16-31 payload
+//    STBI__ZFAST_LIT1       payload = literal
+//    STBI__ZFAST_LIT2       two literals whose codes fit in the index together, payload = lit | lit2 << 8
+//    STBI__ZFAST_LENGTH     payload = base length | extra bits << 9
+//    STBI__ZFAST_END        end of block
+//    STBI__ZFAST_MISS (0)   longer code or unusual symbol, decode it with the stbi__zhuffman
+// distance entries:  bits 0-7 code bits (0 = miss), 8-11 extra bits, 16-31 base distance
+#define STBI__ZFAST_LENGTH_BITS 11
+#define STBI__ZFAST_DISTANCE_BITS 10
+#define STBI__ZFAST_MISS 0
+#define STBI__ZFAST_LIT1 1
+#define STBI__ZFAST_LIT2 2
+#define STBI__ZFAST_LENGTH 3
+#define STBI__ZFAST_END 4
+#endif
+
 // zlib-from-memory implementation for PNG reading
 //    because PNG allows splitting the zlib stream arbitrarily,
 //    and it's annoying structurally to have PNG call ZLIB call PNG,
@@ -4690,6 +4715,10 @@ typedef struct
     int z_expandable;
 
     stbi__zhuffman z_length, z_distance;
+#ifdef STBI_FAST_PNG
+    stbi__uint32 fast_length[1 << STBI__ZFAST_LENGTH_BITS];
+    stbi__uint32 fast_distance[1 << STBI__ZFAST_DISTANCE_BITS];
+#endif
 } stbi__zbuf;
 
 stbi_inline static int stbi__zeof(stbi__zbuf *z)
@@ -4812,9 +4841,255 @@ static const int stbi__zdist_base[32] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49
 static const int stbi__zdist_extra[32] =
     {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
 
+#ifdef STBI_FAST_PNG
+static void stbi__zbuild_fast(stbi__uint32 *table, int bits, const stbi_uc *sizelist, int num, int distance)
+{
+    int i, j, code, sizes[16], next_code[16];
+    memset(sizes, 0, sizeof(sizes));
+    memset(table, 0, sizeof(stbi__uint32) << bits);
+    for (i = 0; i < num; ++i)
+        ++sizes[sizelist[i]];
+    sizes[0] = 0;
+    code = 0;
+    for (i = 1; i < 16; ++i)
+    {
+        code = (code + sizes[i - 1]) << 1;
+        next_code[i] = code;
+    }
+    for (i = 0; i < num; ++i)
+    {
+        int s = sizelist[i];
+        stbi__uint32 entry = 0;
+        if (!s)
+            continue;
+        code = next_code[s]++;
+        if (s > bits)
+            continue;
+        if (distance)
+        {
+            if (i < 30)
+                entry = (stbi__uint32)s | (stbi__uint32)stbi__zdist_extra[i] << 8 | (stbi__uint32)stbi__zdist_base[i] << 16;
+        }
+        else if (i < 256)
+            entry = (stbi__uint32)s | STBI__ZFAST_LIT1 << 8 | (stbi__uint32)i << 16;
+        else if (i == 256)
+            entry = (stbi__uint32)s | STBI__ZFAST_END << 8;
+        else if (i < 286)
+            entry = (stbi__uint32)s | STBI__ZFAST_LENGTH << 8 | (stbi__uint32)(stbi__zlength_base[i - 257] | stbi__zlength_extra[i - 257] << 9) << 16;
+        if (!entry)
+            continue;
+        for (j = stbi__bit_reverse(code, s); j < (1 << bits); j += 1 << s)
+            table[j] = entry;
+    }
+    if (distance)
+        return;
+    // pair up literals: the entry for the bits after a literal code is the next symbol whenever its code
+    // fits in what is left of the index. going down only reads entries that are still single
+    for (j = (1 << bits) - 1; j >= 0; --j)
+    {
+        stbi__uint32 first = table[j], second;
+        int length = first & 255;
+        if (((first >> 8) & 7) != STBI__ZFAST_LIT1 || length >= bits)
+            continue;
+        second = table[j >> length];
+        if (((second >> 8) & 7) == STBI__ZFAST_LIT1 && (int)(second & 255) <= bits - length)
+            table[j] = (stbi__uint32)(length + (second & 255)) | STBI__ZFAST_LIT2 << 8 | (first >> 16 | (second >> 16) << 8) << 16;
+    }
+}
+
+// a symbol the wide table has no entry for, from the low 16 bits of the stream. returns -1 for a bad code
+static int stbi__zfast_symbol(stbi__zhuffman *z, stbi__uint32 bits, int *length)
+{
+    int b, s, k;
+    b = z->fast[bits & STBI__ZFAST_MASK];
+    if (b)
+    {
+        *length = b >> 9;
+        return b & 511;
+    }
+    k = stbi__bit_reverse(bits & 0xffff, 16);
+    for (s = STBI__ZFAST_BITS + 1;; ++s)
+        if (k < z->maxcode[s])
+            break;
+    if (s >= 16)
+        return -1;
+    b = (k >> (16 - s)) - z->firstcode[s] + z->firstsymbol[s];
+    if (b >= STBI__ZNSYMS || z->size[b] != s)
+        return -1;
+    *length = s;
+    return z->value[b];
+}
+
+stbi_inline static unsigned long long stbi__zload64(const stbi_uc *p)
+{
+    return (unsigned long long)p[0] | (unsigned long long)p[1] << 8 | (unsigned long long)p[2] << 16 | (unsigned long long)p[3] << 24 |
+           (unsigned long long)p[4] << 32 | (unsigned long long)p[5] << 40 | (unsigned long long)p[6] << 48 | (unsigned long long)p[7] << 56;
+}
+
+// decode the block while there are at least 8 input bytes and room for the longest match plus a 16 byte
+// overshoot, then hand the bit buffer back for stbi__parse_huffman_block to finish. one refill per
+// iteration is enough: it leaves 56 bits and a length/distance pair needs at most 48
+static int stbi__parse_huffman_block_fast(stbi__zbuf *a, int *done)
+{
+    const stbi_uc *in = a->zbuffer;
+    stbi_uc *out = (stbi_uc *)a->zout;
+    stbi_uc *out_start = (stbi_uc *)a->zout_start;
+    unsigned long long bits = a->code_buffer;
+    int count = a->num_bits;
+    *done = 0;
+    while (a->zbuffer_end - in >= 8 && (stbi_uc *)a->zout_end - out >= 258 + 16)
+    {
+        stbi__uint32 entry;
+        int kind, len, dist, extra, n, z;
+        stbi_uc *p;
+
+        bits |= stbi__zload64(in) << count;
+        in += (63 - count) >> 3;
+        count |= 56;
+
+        entry = a->fast_length[bits & ((1 << STBI__ZFAST_LENGTH_BITS) - 1)];
+        kind = (entry >> 8) & 7;
+        if (kind == STBI__ZFAST_LIT2)
+        {
+            out[0] = (stbi_uc)(entry >> 16);
+            out[1] = (stbi_uc)(entry >> 24);
+            out += 2;
+            bits >>= entry & 255;
+            count -= entry & 255;
+            continue;
+        }
+        if (kind == STBI__ZFAST_LIT1)
+        {
+            *out++ = (stbi_uc)(entry >> 16);
+            bits >>= entry & 255;
+            count -= entry & 255;
+            continue;
+        }
+        if (kind == STBI__ZFAST_END)
+        {
+            bits >>= entry & 255;
+            count -= entry & 255;
+            *done = 1;
+            break;
+        }
+        if (kind == STBI__ZFAST_LENGTH)
+        {
+            bits >>= entry & 255;
+            count -= entry & 255;
+            len = (entry >> 16) & 511;
+            extra = entry >> 25;
+        }
+        else
+        {
+            z = stbi__zfast_symbol(&a->z_length, (stbi__uint32)bits, &n);
+            if (z < 0)
+                return stbi__err("bad huffman code", "Corrupt PNG");
+            bits >>= n;
+            count -= n;
+            if (z < 256)
+            {
+                *out++ = (stbi_uc)z;
+                continue;
+            }
+            if (z == 256)
+            {
+                *done = 1;
+                break;
+            }
+            len = stbi__zlength_base[z - 257];
+            extra = stbi__zlength_extra[z - 257];
+        }
+        if (extra)
+        {
+            len += (int)(bits & ((1u << extra) - 1));
+            bits >>= extra;
+            count -= extra;
+        }
+
+        entry = a->fast_distance[bits & ((1 << STBI__ZFAST_DISTANCE_BITS) - 1)];
+        if (entry & 255)
+        {
+            bits >>= entry & 255;
+            count -= entry & 255;
+            dist = entry >> 16;
+            extra = (entry >> 8) & 15;
+        }
+        else
+        {
+            z = stbi__zfast_symbol(&a->z_distance, (stbi__uint32)bits, &n);
+            if (z < 0 || z >= 30)
+                return stbi__err("bad huffman code", "Corrupt PNG");
+            bits >>= n;
+            count -= n;
+            dist = stbi__zdist_base[z];
+            extra = stbi__zdist_extra[z];
+        }
+        if (extra)
+        {
+            dist += (int)(bits & ((1u << extra) - 1));
+            bits >>= extra;
+            count -= extra;
+        }
+        if (out - out_start < dist)
+            return stbi__err("bad dist", "Corrupt PNG");
+
+        // the copies may run up to 15 bytes past the match, the loop condition keeps that inside the buffer
+        p = out - dist;
+        if (dist >= 16)
+        {
+            stbi_uc *end = out + len;
+            do
+            {
+                memcpy(out, p, 16);
+                out += 16;
+                p += 16;
+            } while (out < end);
+            out = end;
+        }
+        else if (dist >= 8)
+        {
+            stbi_uc *end = out + len;
+            do
+            {
+                memcpy(out, p, 8);
+                out += 8;
+                p += 8;
+            } while (out < end);
+            out = end;
+        }
+        else if (dist == 1)
+        {
+            memset(out, *p, len);
+            out += len;
+        }
+        else
+        {
+            while (len--)
+                *out++ = *p++;
+        }
+    }
+    // give back the whole bytes that were read ahead
+    in -= count >> 3;
+    count &= 7;
+    a->zbuffer = (stbi_uc *)in;
+    a->code_buffer = (stbi__uint32)(bits & ((1u << count) - 1));
+    a->num_bits = count;
+    a->zout = (char *)out;
+    return 1;
+}
+#endif
+
 static int stbi__parse_huffman_block(stbi__zbuf *a)
 {
-    char *zout = a->zout;
+    char *zout;
+#ifdef STBI_FAST_PNG
+    int done;
+    if (!stbi__parse_huffman_block_fast(a, &done))
+        return 0;
+    if (done)
+        return 1;
+#endif
+    zout = a->zout;
     for (;;)
     {
         int z = stbi__zhuffman_decode(a, &a->z_length);
@@ -4945,6 +5220,10 @@ static int stbi__compute_huffman_codes(stbi__zbuf *a)
         return 0;
     if (!stbi__zbuild_huffman(&a->z_distance, lencodes + hlit, hdist))
         return 0;
+#ifdef STBI_FAST_PNG
+    stbi__zbuild_fast(a->fast_length, STBI__ZFAST_LENGTH_BITS, lencodes, hlit, 0);
+    stbi__zbuild_fast(a->fast_distance, STBI__ZFAST_DISTANCE_BITS, lencodes + hlit, hdist, 1);
+#endif
     return 1;
 }
 
@@ -5057,6 +5336,10 @@ static int stbi__parse_zlib(stbi__zbuf *a, int parse_header)
                     return 0;
                 if (!stbi__zbuild_huffman(&a->z_distance, stbi__zdefault_distance, 32))
                     return 0;
+#ifdef STBI_FAST_PNG
+                stbi__zbuild_fast(a->fast_length, STBI__ZFAST_LENGTH_BITS, stbi__zdefault_length, STBI__ZNSYMS, 0);
+                stbi__zbuild_fast(a->fast_distance, STBI__ZFAST_DISTANCE_BITS, stbi__zdefault_distance, 32, 1);
+#endif
             }
             else
             {
@@ -5248,6 +5531,101 @@ static int stbi__paeth(int a, int b, int c)
 
 static const stbi_uc stbi__depth_scale_table[9] = {0, 0xff, 0x55, 0, 0x11, 0, 0, 0, 0x01};
 
+#if defined(STBI_FAST_PNG) && defined(STBI_SSE2) && (defined(STBI__X64_TARGET) || defined(__SSE2__))
+#define STBI__PNG_SSE2
+
+// one pixel of n = 3 or 4 bytes, never touching the byte after a 3 byte pixel
+stbi_inline static __m128i stbi__png_load_pixel(const stbi_uc *p, int n)
+{
+    int v;
+    if (n == 4)
+        memcpy(&v, p, 4);
+    else
+        v = p[0] | p[1] << 8 | p[2] << 16;
+    return _mm_cvtsi32_si128(v);
+}
+
+stbi_inline static void stbi__png_store_pixel(stbi_uc *p, __m128i v, int n)
+{
+    int x = _mm_cvtsi128_si32(v);
+    if (n == 4)
+        memcpy(p, &x, 4);
+    else
+    {
+        p[0] = (stbi_uc)x;
+        p[1] = (stbi_uc)(x >> 8);
+        p[2] = (stbi_uc)(x >> 16);
+    }
+}
+
+// unfilter an 8-bit row with 3 or 4 bytes per pixel after its first pixel, which the caller has done:
+// cur, raw and prior point at the second pixel and nk bytes are left. Up runs 16 bytes at a time, the
+// others depend on the pixel to the left and run one pixel per register. returns 0 for "none"
+static int stbi__png_unfilter_sse2(int filter, stbi_uc *cur, const stbi_uc *raw, const stbi_uc *prior, int nk, int bpp)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a, b, c;
+    int k = 0;
+    switch (filter)
+    {
+    case STBI__F_up:
+        for (; k + 16 <= nk; k += 16)
+            _mm_storeu_si128((__m128i *)(cur + k), _mm_add_epi8(_mm_loadu_si128((const __m128i *)(raw + k)), _mm_loadu_si128((const __m128i *)(prior + k))));
+        for (; k < nk; ++k)
+            cur[k] = STBI__BYTECAST(raw[k] + prior[k]);
+        return 1;
+    case STBI__F_sub:
+    case STBI__F_paeth_first: // with no row above paeth always picks the left pixel
+        a = stbi__png_load_pixel(cur - bpp, bpp);
+        for (; k < nk; k += bpp)
+        {
+            a = _mm_add_epi8(a, stbi__png_load_pixel(raw + k, bpp));
+            stbi__png_store_pixel(cur + k, a, bpp);
+        }
+        return 1;
+    case STBI__F_avg:
+    case STBI__F_avg_first:
+        // avg_epu8 rounds up, the filter rounds down
+        a = stbi__png_load_pixel(cur - bpp, bpp);
+        for (; k < nk; k += bpp)
+        {
+            __m128i avg;
+            b = filter == STBI__F_avg ? stbi__png_load_pixel(prior + k, bpp) : zero;
+            avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+            a = _mm_add_epi8(stbi__png_load_pixel(raw + k, bpp), avg);
+            stbi__png_store_pixel(cur + k, a, bpp);
+        }
+        return 1;
+    case STBI__F_paeth:
+        // in 16 bit lanes: p - a = b - c, p - b = a - c, p - c = (b - c) + (a - c); ties go to a, then b
+        a = _mm_unpacklo_epi8(stbi__png_load_pixel(cur - bpp, bpp), zero);
+        c = _mm_unpacklo_epi8(stbi__png_load_pixel(prior - bpp, bpp), zero);
+        for (; k < nk; k += bpp)
+        {
+            __m128i pa, pb, pc, smallest, nearest, x;
+            b = _mm_unpacklo_epi8(stbi__png_load_pixel(prior + k, bpp), zero);
+            pa = _mm_sub_epi16(b, c);
+            pb = _mm_sub_epi16(a, c);
+            pc = _mm_add_epi16(pa, pb);
+            pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+            pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+            pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+            smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+            x = _mm_cmpeq_epi16(smallest, pb);
+            nearest = _mm_or_si128(_mm_and_si128(x, b), _mm_andnot_si128(x, c));
+            x = _mm_cmpeq_epi16(smallest, pa);
+            nearest = _mm_or_si128(_mm_and_si128(x, a), _mm_andnot_si128(x, nearest));
+            x = _mm_add_epi8(stbi__png_load_pixel(raw + k, bpp), _mm_packus_epi16(nearest, nearest));
+            stbi__png_store_pixel(cur + k, x, bpp);
+            a = _mm_unpacklo_epi8(x, zero);
+            c = b;
+        }
+        return 1;
+    }
+    return 0;
+}
+#endif
+
 // create the png data from post-deflated data
 static int stbi__create_png_image_raw(stbi__png *a, stbi_uc *raw, stbi__uint32 raw_len, int out_n, stbi__uint32 x, stbi__uint32 y, int depth, int color)
 {
@@ -5360,9 +5738,15 @@ static int stbi__create_png_image_raw(stbi__png *a, stbi_uc *raw, stbi__uint32 r
         if (depth < 8 || img_n == out_n)
         {
             int nk = (width - 1) * filter_bytes;
+            int unfiltered = 0;
+#ifdef STBI__PNG_SSE2
+            if (depth == 8 && (filter_bytes == 3 || filter_bytes == 4))
+                unfiltered = stbi__png_unfilter_sse2(filter, cur, raw, prior, nk, filter_bytes);
+#endif
 #define STBI__CASE(f) \
     case f:           \
         for (k = 0; k < nk; ++k)
+            if (!unfiltered)
             switch (filter)
             {
             // "none" filter turns into a memcpy here; make that explicit.
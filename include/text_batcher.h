@@ -0,0 +1,206 @@
+#ifndef TEXT_BATCHER_H
+#define TEXT_BATCHER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <shader.h>
+#include <gl_state.h>
+
+#include <vector>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+
+// vertex layout of resources/shaders/text.vs
+struct TextVertex
+{
+    GLfloat X, Y;
+    GLfloat U, V;
+    GLubyte R, G, B, A;
+};
+
+// Collects glyph quads from every drawText call of a frame and draws them with one indexed draw per
+// (shader, atlas texture) pair. Colors travel per vertex so strings of different colors still batch.
+// Batches with different keys are drawn in the order they were first used.
+class TextBatcher
+{
+public:
+    TextBatcher() : VertexCapacity(0), QuadCapacity(0)
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        GLState::get().bindVertexArray(VAO);
+        GLState::get().bindArrayBuffer(VBO);
+        setupVertexAttributes();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        GLState::get().bindVertexArray(0);
+    }
+
+    ~TextBatcher()
+    {
+        GLState::get().deleteVertexArray(VAO);
+        GLState::get().deleteBuffer(VBO);
+        GLState::get().deleteBuffer(EBO);
+    }
+
+    TextBatcher(const TextBatcher &) = delete;
+    TextBatcher &operator=(const TextBatcher &) = delete;
+
+    // queue a screen aligned quad, uv is (u0, v0, u1, v1) with v0 at the top edge
+    void addQuad(Shader &shader, GLuint texture, GLfloat x, GLfloat y, GLfloat w, GLfloat h, const glm::vec4 &uv, const glm::vec3 &color)
+    {
+        appendQuad(vertices(shader, texture), x, y, w, h, uv, color);
+    }
+
+    // vertex list of the batch for (shader, texture), for callers that append many quads at once
+    std::vector<TextVertex> &vertices(Shader &shader, GLuint texture)
+    {
+        return batchFor(shader, texture).Vertices;
+    }
+
+    // four vertices per quad, drawn with the indices from quadIndices()
+    static void appendQuad(std::vector<TextVertex> &out, GLfloat x, GLfloat y, GLfloat w, GLfloat h, const glm::vec4 &uv, const glm::vec3 &color)
+    {
+        GLubyte r = toByte(color.x), g = toByte(color.y), b = toByte(color.z);
+        out.push_back(TextVertex{x, y + h, uv.x, uv.y, r, g, b, 255});
+        out.push_back(TextVertex{x, y, uv.x, uv.w, r, g, b, 255});
+        out.push_back(TextVertex{x + w, y, uv.z, uv.w, r, g, b, 255});
+        out.push_back(TextVertex{x + w, y + h, uv.z, uv.y, r, g, b, 255});
+    }
+
+    // color channel in [0, 1] to a normalized byte
+    static GLubyte toByte(float value)
+    {
+        return static_cast<GLubyte>(glm::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    static std::vector<GLuint> quadIndices(size_t quads)
+    {
+        std::vector<GLuint> indices(quads * 6);
+        for (size_t i = 0; i < quads; i++)
+        {
+            GLuint base = static_cast<GLuint>(i * 4);
+            GLuint quad[6] = {base, base + 1, base + 2, base, base + 2, base + 3};
+            std::memcpy(&indices[i * 6], quad, sizeof(quad));
+        }
+        return indices;
+    }
+
+    // attribute layout of TextVertex for the currently bound VAO and array buffer
+    static void setupVertexAttributes()
+    {
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void *)offsetof(TextVertex, X));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void *)offsetof(TextVertex, U));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(TextVertex), (void *)offsetof(TextVertex, R));
+    }
+
+    size_t quadCount() const
+    {
+        size_t quads = 0;
+        for (const Batch &batch : Batches)
+            quads += batch.Vertices.size() / 4;
+        return quads;
+    }
+
+    // upload everything queued since the last flush into the streaming buffer and draw it
+    void flush()
+    {
+        size_t vertexCount = 0;
+        for (const Batch &batch : Batches)
+            vertexCount += batch.Vertices.size();
+        if (vertexCount == 0)
+            return;
+
+        GLState::get().bindVertexArray(VAO);
+        GLState::get().bindArrayBuffer(VBO);
+        reserve(vertexCount);
+
+        // orphan the previous contents so the driver never waits on last frame's draws
+        void *mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, vertexCount * sizeof(TextVertex), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (!mapped)
+        {
+            clear();
+            return;
+        }
+        size_t offset = 0;
+        for (const Batch &batch : Batches)
+        {
+            std::memcpy(static_cast<char *>(mapped) + offset * sizeof(TextVertex), batch.Vertices.data(), batch.Vertices.size() * sizeof(TextVertex));
+            offset += batch.Vertices.size();
+        }
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+
+        GLint baseVertex = 0;
+        for (const Batch &batch : Batches)
+        {
+            GLsizei quads = static_cast<GLsizei>(batch.Vertices.size() / 4);
+            if (quads > 0)
+            {
+                batch.Program->use();
+                batch.Program->setMat4("model"_u, glm::mat4(1.0f));
+                GLState::get().bindTexture(0, GL_TEXTURE_2D, batch.Texture);
+                glDrawElementsBaseVertex(GL_TRIANGLES, quads * 6, GL_UNSIGNED_INT, (void *)0, baseVertex);
+            }
+            baseVertex += static_cast<GLint>(batch.Vertices.size());
+        }
+        clear();
+    }
+
+    // drop queued quads without drawing them, keeps the allocations for the next frame
+    void clear()
+    {
+        for (Batch &batch : Batches)
+            batch.Vertices.clear();
+    }
+
+private:
+    struct Batch
+    {
+        Shader *Program;
+        GLuint Texture;
+        std::vector<TextVertex> Vertices;
+    };
+
+    unsigned int VAO, VBO, EBO;
+    size_t VertexCapacity;
+    size_t QuadCapacity;
+    std::vector<Batch> Batches;
+
+    Batch &batchFor(Shader &shader, GLuint texture)
+    {
+        for (Batch &batch : Batches)
+        {
+            if (batch.Program == &shader && batch.Texture == texture)
+                return batch;
+        }
+        Batches.push_back(Batch{&shader, texture, std::vector<TextVertex>()});
+        return Batches.back();
+    }
+
+    // grow the vertex buffer and the shared quad index buffer geometrically, expects VAO and VBO bound
+    void reserve(size_t vertexCount)
+    {
+        if (vertexCount > VertexCapacity)
+        {
+            while (VertexCapacity < vertexCount)
+                VertexCapacity = VertexCapacity ? VertexCapacity * 2 : 4096;
+            glBufferData(GL_ARRAY_BUFFER, VertexCapacity * sizeof(TextVertex), NULL, GL_STREAM_DRAW);
+        }
+        size_t quadCount = 0;
+        for (const Batch &batch : Batches)
+            quadCount = std::max(quadCount, batch.Vertices.size() / 4);
+        if (quadCount > QuadCapacity)
+        {
+            while (QuadCapacity < quadCount)
+                QuadCapacity = QuadCapacity ? QuadCapacity * 2 : 1024;
+            std::vector<GLuint> indices = quadIndices(QuadCapacity);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        }
+    }
+};
+#endif
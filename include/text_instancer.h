@@ -0,0 +1,230 @@
+#ifndef TEXT_INSTANCER_H
+#define TEXT_INSTANCER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <shader.h>
+#include <gl_state.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// one glyph of instanced text, see resources/shaders/text_instanced.vs
+struct GlyphInstance
+{
+    GLfloat X, Y;  // pen position on the baseline
+    GLfloat Scale; // screen pixels per glyph table pixel
+    GLuint Glyph;  // entry in the GlyphTable
+    GLubyte R, G, B, A;
+};
+
+// Metrics and atlas UVs of every resident glyph in a texture buffer, two RGBA32F texels per entry:
+//   (bearing x, bearing y - height, width, height) in raster pixels
+//   (u0, v0, u1, v1)                               v0 at the top row
+// Entries are handed out when a glyph enters the atlas and given back when it is evicted, so an
+// entry index is stable for as long as the glyph stays resident. Changes are kept in a CPU copy and
+// uploaded in one range by upload().
+class GlyphTable
+{
+public:
+    GLuint TextureID;
+
+    GlyphTable() : Capacity(0), DirtyBegin(0), DirtyEnd(0)
+    {
+        glGenBuffers(1, &Buffer);
+        glGenTextures(1, &TextureID);
+    }
+
+    ~GlyphTable()
+    {
+        GLState::get().deleteTexture(TextureID);
+        glDeleteBuffers(1, &Buffer);
+    }
+
+    GlyphTable(const GlyphTable &) = delete;
+    GlyphTable &operator=(const GlyphTable &) = delete;
+
+    GLuint allocate()
+    {
+        if (!FreeEntries.empty())
+        {
+            GLuint entry = FreeEntries.back();
+            FreeEntries.pop_back();
+            return entry;
+        }
+        Texels.resize(Texels.size() + 2, glm::vec4(0.0f));
+        return static_cast<GLuint>(Texels.size() / 2 - 1);
+    }
+
+    void release(GLuint entry)
+    {
+        FreeEntries.push_back(entry);
+    }
+
+    void set(GLuint entry, const glm::ivec2 &size, const glm::ivec2 &bearing, const glm::vec4 &uv)
+    {
+        Texels[entry * 2] = glm::vec4(bearing.x, bearing.y - size.y, size.x, size.y);
+        Texels[entry * 2 + 1] = uv;
+        if (DirtyBegin == DirtyEnd)
+        {
+            DirtyBegin = entry * 2;
+            DirtyEnd = entry * 2 + 2;
+        }
+        else
+        {
+            DirtyBegin = std::min<size_t>(DirtyBegin, entry * 2);
+            DirtyEnd = std::max<size_t>(DirtyEnd, entry * 2 + 2);
+        }
+    }
+
+    // push the entries changed since the last upload, growing the buffer geometrically
+    void upload()
+    {
+        if (Texels.size() > Capacity)
+        {
+            while (Capacity < Texels.size())
+                Capacity = Capacity ? Capacity * 2 : 1024;
+            glBindBuffer(GL_TEXTURE_BUFFER, Buffer);
+            glBufferData(GL_TEXTURE_BUFFER, Capacity * sizeof(glm::vec4), NULL, GL_DYNAMIC_DRAW);
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, Texels.size() * sizeof(glm::vec4), Texels.data());
+            // a new data store has to be attached to the texture again
+            GLState::get().bindTextureForUpdate(0, GL_TEXTURE_BUFFER, TextureID);
+            glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, Buffer);
+        }
+        else if (DirtyBegin != DirtyEnd)
+        {
+            glBindBuffer(GL_TEXTURE_BUFFER, Buffer);
+            glBufferSubData(GL_TEXTURE_BUFFER, DirtyBegin * sizeof(glm::vec4), (DirtyEnd - DirtyBegin) * sizeof(glm::vec4), &Texels[DirtyBegin]);
+        }
+        DirtyBegin = DirtyEnd = 0;
+    }
+
+private:
+    GLuint Buffer;
+    size_t Capacity; // in texels
+    std::vector<glm::vec4> Texels;
+    std::vector<GLuint> FreeEntries;
+    size_t DirtyBegin, DirtyEnd; // texel range changed since the last upload
+};
+
+// GPU side text layout: the CPU only streams one GlyphInstance (20 bytes) per glyph and the vertex
+// shader expands it into a quad from the GlyphTable, instead of four 20 byte vertices per glyph.
+// Meant for text that changes every frame; draws one instanced triangle strip per
+// (shader, atlas texture) pair in the order the pairs were first used, like TextBatcher.
+class TextInstancer
+{
+public:
+    TextInstancer() : Capacity(0)
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        GLState::get().bindVertexArray(VAO);
+        GLState::get().bindArrayBuffer(VBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), (void *)offsetof(GlyphInstance, X));
+        glVertexAttribDivisor(0, 1);
+        glEnableVertexAttribArray(1);
+        glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(GlyphInstance), (void *)offsetof(GlyphInstance, Glyph));
+        glVertexAttribDivisor(1, 1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(GlyphInstance), (void *)offsetof(GlyphInstance, R));
+        glVertexAttribDivisor(2, 1);
+        GLState::get().bindVertexArray(0);
+    }
+
+    ~TextInstancer()
+    {
+        GLState::get().deleteVertexArray(VAO);
+        GLState::get().deleteBuffer(VBO);
+    }
+
+    TextInstancer(const TextInstancer &) = delete;
+    TextInstancer &operator=(const TextInstancer &) = delete;
+
+    // instance list of the batch for (shader, texture)
+    std::vector<GlyphInstance> &instances(Shader &shader, GLuint texture)
+    {
+        for (Batch &batch : Batches)
+        {
+            if (batch.Program == &shader && batch.Texture == texture)
+                return batch.Instances;
+        }
+        Batches.push_back(Batch{&shader, texture, std::vector<GlyphInstance>()});
+        return Batches.back().Instances;
+    }
+
+    // draw everything queued since the last flush, table must already hold every referenced entry
+    void flush(const GlyphTable &table)
+    {
+        size_t count = 0;
+        for (const Batch &batch : Batches)
+            count += batch.Instances.size();
+        if (count == 0)
+            return;
+
+        GLState::get().bindVertexArray(VAO);
+        GLState::get().bindArrayBuffer(VBO);
+        if (count > Capacity)
+        {
+            while (Capacity < count)
+                Capacity = Capacity ? Capacity * 2 : 4096;
+            glBufferData(GL_ARRAY_BUFFER, Capacity * sizeof(GlyphInstance), NULL, GL_STREAM_DRAW);
+        }
+        // orphan the previous contents so the driver never waits on last frame's draws
+        void *mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, count * sizeof(GlyphInstance), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (!mapped)
+        {
+            clear();
+            return;
+        }
+        size_t offset = 0;
+        for (const Batch &batch : Batches)
+        {
+            std::memcpy(static_cast<char *>(mapped) + offset * sizeof(GlyphInstance), batch.Instances.data(), batch.Instances.size() * sizeof(GlyphInstance));
+            offset += batch.Instances.size();
+        }
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+
+        GLState::get().bindTexture(1, GL_TEXTURE_BUFFER, table.TextureID);
+        offset = 0;
+        for (const Batch &batch : Batches)
+        {
+            if (!batch.Instances.empty())
+            {
+                batch.Program->use();
+                batch.Program->setMat4("model"_u, glm::mat4(1.0f));
+                batch.Program->setInt("glyphs"_u, 1);
+                GLState::get().bindTexture(0, GL_TEXTURE_2D, batch.Texture);
+                // GL 3.3 has no base instance, so the attribute pointers move instead
+                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), (void *)(offset * sizeof(GlyphInstance) + offsetof(GlyphInstance, X)));
+                glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(GlyphInstance), (void *)(offset * sizeof(GlyphInstance) + offsetof(GlyphInstance, Glyph)));
+                glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(GlyphInstance), (void *)(offset * sizeof(GlyphInstance) + offsetof(GlyphInstance, R)));
+                glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(batch.Instances.size()));
+            }
+            offset += batch.Instances.size();
+        }
+        clear();
+    }
+
+    void clear()
+    {
+        for (Batch &batch : Batches)
+            batch.Instances.clear();
+    }
+
+private:
+    struct Batch
+    {
+        Shader *Program;
+        GLuint Texture;
+        std::vector<GlyphInstance> Instances;
+    };
+
+    unsigned int VAO, VBO;
+    size_t Capacity; // in instances
+    std::vector<Batch> Batches;
+};
+#endif
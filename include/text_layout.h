@@ -0,0 +1,134 @@
+#ifndef TEXT_LAYOUT_H
+#define TEXT_LAYOUT_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <shader.h>
+#include <gl_state.h>
+#include <ui_text.h>
+#include <text_batcher.h>
+
+#include <string>
+#include <vector>
+
+// Retained text: the glyph quads of one string are laid out once and kept in a GPU buffer.
+// The glyphs it uses stay pinned in the font's atlas while the layout holds them, so evictions caused by
+// other text never touch it. It is rebuilt only when the string or its parameters change, or when the
+// font repacks its atlas, so drawing unchanged text costs one draw call and no per-glyph CPU work.
+// The font must outlive the layout.
+class TextLayout
+{
+public:
+    TextLayout() : Font(nullptr), Generation(0), Evictions(0), Complete(true), X(0.0f), Y(0.0f), Scale(1.0f), Color(1.0f), WrapWidth(0.0f), Align(TEXT_ALIGN_LEFT), Style(FONT_REGULAR), Dirty(true), IndexCount(0), QuadCapacity(0)
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        GLState::get().bindVertexArray(VAO);
+        GLState::get().bindArrayBuffer(VBO);
+        TextBatcher::setupVertexAttributes();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        GLState::get().bindVertexArray(0);
+    }
+
+    ~TextLayout()
+    {
+        if (Font)
+            Font->unpinGlyphs(Pinned);
+        GLState::get().deleteVertexArray(VAO);
+        GLState::get().deleteBuffer(VBO);
+        GLState::get().deleteBuffer(EBO);
+    }
+
+    TextLayout(const TextLayout &) = delete;
+    TextLayout &operator=(const TextLayout &) = delete;
+
+    // cheap to call every frame, only marks the layout dirty when something actually differs.
+    // wrapWidth > 0 word-wraps the text as a paragraph of that width, see UiText::layoutText
+    void set(const std::string &text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color, GLfloat wrapWidth = 0.0f, TextAlign align = TEXT_ALIGN_LEFT, FontStyle style = FONT_REGULAR)
+    {
+        if (text == Text && x == X && y == Y && scale == Scale && color == Color && wrapWidth == WrapWidth && align == Align && style == Style)
+            return;
+        // line breaks only depend on the text, the font and the wrap width relative to the scale
+        if (text != Text || scale != Scale || wrapWidth != WrapWidth || style != Style)
+            Lines.clear();
+        Text = text;
+        X = x;
+        Y = y;
+        Scale = scale;
+        Color = color;
+        WrapWidth = wrapWidth;
+        Align = align;
+        Style = style;
+        Dirty = true;
+    }
+
+    // projection and view come from the currently bound FrameData record
+    void draw(UiText &font, Shader &shader)
+    {
+        if (Dirty || Font != &font || Generation != font.generation() || (!Complete && Evictions != font.evictions()))
+            rebuild(font);
+        if (IndexCount == 0)
+            return;
+        shader.use();
+        shader.setMat4("model"_u, glm::mat4(1.0f));
+        GLState::get().bindTexture(0, GL_TEXTURE_2D, font.atlasTexture());
+        GLState::get().bindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, IndexCount, GL_UNSIGNED_INT, (void *)0);
+    }
+
+private:
+    unsigned int VAO, VBO, EBO;
+    UiText *Font;
+    unsigned int Generation;
+    unsigned int Evictions; // font.evictions() at the last rebuild, only checked while incomplete
+    bool Complete;          // every glyph made it into the atlas
+
+    std::string Text;
+    GLfloat X, Y, Scale;
+    glm::vec3 Color;
+    GLfloat WrapWidth;
+    TextAlign Align;
+    FontStyle Style;
+    bool Dirty;
+    std::vector<TextLine> Lines; // empty until broken, reused while the text, wrap width and strike stay the same
+
+    GLsizei IndexCount;
+    size_t QuadCapacity;
+    std::vector<TextVertex> Vertices;
+    std::vector<uint64_t> Glyphs, Pinned; // keys of the glyphs in the buffer, pinned in Font
+
+    void rebuild(UiText &font)
+    {
+        if (Lines.empty() || Font != &font)
+            font.breakLines(Text, WrapWidth, Scale, Style, Lines);
+        Vertices.clear();
+        Glyphs.clear();
+        font.layoutLines(Text, Lines, X, Y, Scale, Color, WrapWidth, Align, Vertices, Style, &Glyphs);
+        // pin the new set before letting go of the old one, glyphs in both never drop to zero pins
+        Complete = font.pinGlyphs(Glyphs);
+        if (Font)
+            Font->unpinGlyphs(Pinned);
+        Pinned.swap(Glyphs);
+        size_t quads = Vertices.size() / 4;
+
+        GLState::get().bindVertexArray(VAO);
+        GLState::get().bindArrayBuffer(VBO);
+        glBufferData(GL_ARRAY_BUFFER, Vertices.size() * sizeof(TextVertex), Vertices.data(), GL_STATIC_DRAW);
+        if (quads > QuadCapacity)
+        {
+            QuadCapacity = quads;
+            std::vector<GLuint> indices = TextBatcher::quadIndices(quads);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        }
+        IndexCount = static_cast<GLsizei>(quads * 6);
+
+        Font = &font;
+        // layoutText may itself evict glyphs, so read the counters after laying out
+        Generation = font.generation();
+        Evictions = font.evictions();
+        Dirty = false;
+    }
+};
+#endif
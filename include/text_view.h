@@ -0,0 +1,382 @@
+#ifndef TEXT_VIEW_H
+#define TEXT_VIEW_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <shader.h>
+#include <gl_state.h>
+#include <ui_text.h>
+#include <text_batcher.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Scrolling view over a large, append-only text document such as a live log.
+// Text is copied into fixed size chunks that never move, and a line index points into them. The index
+// is kept in fixed size blocks as well, so appending never copies existing lines or their index. Only the rows inside the viewport are laid out and
+// uploaded, which keeps the cost of a frame proportional to the visible rows, not to the document.
+// With wrapping on, each line is broken once when it is appended to count its rows. Changing the
+// wrap width or the scale re-counts every line. The glyphs of the rows on screen stay pinned in the
+// font's atlas, so evictions caused by other text do not force a rebuild.
+class TextView
+{
+public:
+    // (x, y) is the bottom left corner of the viewport in screen pixels
+    TextView(UiText &font, GLfloat x, GLfloat y, GLfloat width, GLfloat height, GLfloat scale = 0.5f, bool wrap = false)
+        : Font(font), X(x), Y(y), Width(width), Height(height), Scale(scale), Wrap(wrap), Color(1.0f),
+          ChunkUsed(0), TotalRows(0), FirstRow(0), Follow(true), Dirty(true), Generation(0), Evictions(0), Complete(true), IndexCount(0), QuadCapacity(0)
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        GLState::get().bindVertexArray(VAO);
+        GLState::get().bindArrayBuffer(VBO);
+        TextBatcher::setupVertexAttributes();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        GLState::get().bindVertexArray(0);
+    }
+
+    ~TextView()
+    {
+        Font.unpinGlyphs(Pinned);
+        GLState::get().deleteVertexArray(VAO);
+        GLState::get().deleteBuffer(VBO);
+        GLState::get().deleteBuffer(EBO);
+    }
+
+    TextView(const TextView &) = delete;
+    TextView &operator=(const TextView &) = delete;
+
+    // append one or more lines separated by '\n', a trailing '\n' does not start an empty line.
+    // costs O(appended text), while following the tail the view stays scrolled to the bottom
+    void append(const std::string &text)
+    {
+        const char *c = text.data(), *end = text.data() + text.size();
+        while (c != end)
+        {
+            const char *newline = static_cast<const char *>(std::memchr(c, '\n', end - c));
+            const char *lineEnd = newline ? newline : end;
+            appendLine(c, lineEnd);
+            c = newline ? newline + 1 : end;
+        }
+        if (Follow)
+            scrollToBottom();
+    }
+
+    void clear()
+    {
+        Chunks.clear();
+        Lines.clear();
+        RowStart.clear();
+        ChunkUsed = 0;
+        TotalRows = 0;
+        FirstRow = 0;
+        Follow = true;
+        Dirty = true;
+    }
+
+    void setColor(glm::vec3 color)
+    {
+        if (color != Color)
+        {
+            Color = color;
+            Dirty = true;
+        }
+    }
+
+    // moving or resizing the viewport is cheap unless wrapping is on and the wrap width changes
+    void setViewport(GLfloat x, GLfloat y, GLfloat width, GLfloat height)
+    {
+        bool rewrap = Wrap && width != Width;
+        X = x;
+        Y = y;
+        Width = width;
+        Height = height;
+        if (rewrap)
+            recountRows();
+        clampScroll();
+        Dirty = true;
+    }
+
+    void setScale(GLfloat scale)
+    {
+        if (scale == Scale)
+            return;
+        Scale = scale;
+        if (Wrap)
+            recountRows();
+        clampScroll();
+        Dirty = true;
+    }
+
+    // scroll by whole rows, positive moves towards the end of the document
+    void scrollBy(long rows)
+    {
+        long target = static_cast<long>(FirstRow) + rows;
+        scrollTo(target < 0 ? 0 : static_cast<size_t>(target));
+    }
+
+    void scrollTo(size_t row)
+    {
+        size_t previous = FirstRow;
+        FirstRow = row;
+        clampScroll();
+        // scrolling back to the bottom resumes following new lines
+        Follow = FirstRow == maxFirstRow();
+        if (FirstRow != previous)
+            Dirty = true;
+    }
+
+    void scrollToBottom()
+    {
+        scrollTo(maxFirstRow());
+    }
+
+    size_t lineCount() const
+    {
+        return Lines.size();
+    }
+
+    size_t rowCount() const
+    {
+        return TotalRows;
+    }
+
+    size_t firstRow() const
+    {
+        return FirstRow;
+    }
+
+    size_t visibleRows()
+    {
+        GLfloat lineHeight = Font.lineHeight(Scale);
+        return lineHeight > 0.0f ? static_cast<size_t>(Height / lineHeight) : 0;
+    }
+
+    // projection and view come from the currently bound FrameData record
+    void draw(Shader &shader)
+    {
+        if (Dirty || Generation != Font.generation() || (!Complete && Evictions != Font.evictions()))
+            rebuild();
+        if (IndexCount == 0)
+            return;
+        shader.use();
+        shader.setMat4("model"_u, glm::mat4(1.0f));
+        GLState::get().bindTexture(0, GL_TEXTURE_2D, Font.atlasTexture());
+        GLState::get().bindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, IndexCount, GL_UNSIGNED_INT, (void *)0);
+    }
+
+private:
+    // append-only array in blocks of BLOCK_SIZE entries, growing it allocates one block and moves nothing
+    template <typename T>
+    class BlockArray
+    {
+    public:
+        static const size_t BLOCK_SIZE = 1 << 16;
+
+        void push_back(const T &value)
+        {
+            if (Count == Blocks.size() * BLOCK_SIZE)
+                Blocks.emplace_back(new T[BLOCK_SIZE]);
+            Blocks[Count / BLOCK_SIZE][Count % BLOCK_SIZE] = value;
+            Count++;
+        }
+
+        T &operator[](size_t i) { return Blocks[i / BLOCK_SIZE][i % BLOCK_SIZE]; }
+        const T &operator[](size_t i) const { return Blocks[i / BLOCK_SIZE][i % BLOCK_SIZE]; }
+        T &back() { return (*this)[Count - 1]; }
+        size_t size() const { return Count; }
+
+        void clear()
+        {
+            Blocks.clear();
+            Count = 0;
+        }
+
+    private:
+        std::vector<std::unique_ptr<T[]>> Blocks;
+        size_t Count = 0;
+    };
+
+    struct LineRef
+    {
+        uint32_t Chunk;
+        uint32_t Offset;
+        uint32_t Length;
+    };
+
+    // lines are never split across chunks, a line longer than a chunk gets a chunk of its own
+    static const size_t CHUNK_SIZE = 1 << 16;
+
+    UiText &Font;
+    GLfloat X, Y, Width, Height, Scale;
+    bool Wrap;
+    glm::vec3 Color;
+
+    std::vector<std::unique_ptr<char[]>> Chunks;
+    size_t ChunkUsed; // bytes used in Chunks.back()
+    size_t ChunkCapacity = 0;
+    BlockArray<LineRef> Lines;
+    BlockArray<size_t> RowStart; // first row of every line, only kept when wrapping
+    size_t TotalRows;
+
+    size_t FirstRow;
+    bool Follow; // keep the view at the bottom while lines are appended
+    bool Dirty;
+    unsigned int Generation;
+    unsigned int Evictions; // Font.evictions() at the last rebuild, only checked while incomplete
+    bool Complete;          // every glyph on screen made it into the atlas
+
+    unsigned int VAO, VBO, EBO;
+    GLsizei IndexCount;
+    size_t QuadCapacity;
+    std::vector<TextVertex> Vertices;
+    std::vector<TextLine> Breaks;
+    std::vector<uint64_t> Glyphs, Pinned; // keys of the glyphs in the buffer, pinned in Font
+
+    void appendLine(const char *begin, const char *end)
+    {
+        size_t length = end - begin;
+        if (Chunks.empty() || ChunkUsed + length > ChunkCapacity)
+        {
+            ChunkCapacity = length > CHUNK_SIZE ? length : CHUNK_SIZE;
+            Chunks.emplace_back(new char[ChunkCapacity]);
+            ChunkUsed = 0;
+        }
+        std::memcpy(Chunks.back().get() + ChunkUsed, begin, length);
+        Lines.push_back(LineRef{static_cast<uint32_t>(Chunks.size() - 1), static_cast<uint32_t>(ChunkUsed), static_cast<uint32_t>(length)});
+        ChunkUsed += length;
+
+        if (Wrap)
+        {
+            RowStart.push_back(TotalRows);
+            TotalRows += rowsOf(Lines.back());
+        }
+        else
+            TotalRows++;
+        // the view only changes if the new rows could be on screen
+        if (Follow || TotalRows - 1 < FirstRow + visibleRows())
+            Dirty = true;
+    }
+
+    const char *text(const LineRef &line) const
+    {
+        return Chunks[line.Chunk].get() + line.Offset;
+    }
+
+    size_t rowsOf(const LineRef &line)
+    {
+        Breaks.clear();
+        const char *begin = text(line);
+        Font.breakRange(begin, begin + line.Length, Width, Scale, Breaks);
+        return Breaks.size();
+    }
+
+    void recountRows()
+    {
+        RowStart.clear();
+        TotalRows = 0;
+        if (!Wrap)
+        {
+            TotalRows = Lines.size();
+            return;
+        }
+        for (size_t line = 0; line < Lines.size(); line++)
+        {
+            RowStart.push_back(TotalRows);
+            TotalRows += rowsOf(Lines[line]);
+        }
+    }
+
+    size_t maxFirstRow()
+    {
+        size_t visible = visibleRows();
+        return TotalRows > visible ? TotalRows - visible : 0;
+    }
+
+    void clampScroll()
+    {
+        FirstRow = std::min(FirstRow, maxFirstRow());
+    }
+
+    // line containing row, O(log lines) when wrapping
+    size_t lineOfRow(size_t row) const
+    {
+        if (!Wrap)
+            return row;
+        // last line starting at or before row
+        size_t first = 0, count = RowStart.size();
+        while (count > 1)
+        {
+            size_t half = count / 2;
+            if (RowStart[first + half] <= row)
+            {
+                first += half;
+                count -= half;
+            }
+            else
+                count = half;
+        }
+        return first;
+    }
+
+    void rebuild()
+    {
+        Vertices.clear();
+        Glyphs.clear();
+        size_t visible = visibleRows();
+        size_t lastRow = std::min(TotalRows, FirstRow + visible);
+        GLfloat lineHeight = Font.lineHeight(Scale);
+        // baseline of the top row, the rows hang down from the top edge of the viewport
+        GLfloat baseline = Y + Height - lineHeight + Font.descender(Scale);
+
+        size_t row = FirstRow;
+        for (size_t line = row < lastRow ? lineOfRow(row) : Lines.size(); row < lastRow && line < Lines.size(); line++)
+        {
+            const char *begin = text(Lines[line]);
+            const char *end = begin + Lines[line].Length;
+            if (!Wrap)
+            {
+                Font.layoutRange(begin, end, X, baseline, Scale, Color, Vertices, Width, FONT_REGULAR, &Glyphs);
+                baseline -= lineHeight;
+                row++;
+                continue;
+            }
+            Breaks.clear();
+            Font.breakRange(begin, end, Width, Scale, Breaks);
+            // the first visible line may start above the viewport
+            for (size_t i = row - RowStart[line]; i < Breaks.size() && row < lastRow; i++, row++)
+            {
+                Font.layoutRange(begin + Breaks[i].Begin, begin + Breaks[i].End, X, baseline, Scale, Color, Vertices, 0.0f, FONT_REGULAR, &Glyphs);
+                baseline -= lineHeight;
+            }
+        }
+
+        Complete = Font.pinGlyphs(Glyphs);
+        Font.unpinGlyphs(Pinned);
+        Pinned.swap(Glyphs);
+
+        size_t quads = Vertices.size() / 4;
+        GLState::get().bindVertexArray(VAO);
+        GLState::get().bindArrayBuffer(VBO);
+        glBufferData(GL_ARRAY_BUFFER, Vertices.size() * sizeof(TextVertex), Vertices.data(), GL_STREAM_DRAW);
+        if (quads > QuadCapacity)
+        {
+            QuadCapacity = std::max(quads, QuadCapacity * 2);
+            std::vector<GLuint> indices = TextBatcher::quadIndices(QuadCapacity);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        }
+        IndexCount = static_cast<GLsizei>(quads * 6);
+        // layout may itself evict glyphs, so read the counters after laying out
+        Generation = Font.generation();
+        Evictions = Font.evictions();
+        Dirty = false;
+    }
+};
+#endif
@@ -0,0 +1,300 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+
+#include <gl_state.h>
+#include <baked_texture.h>
+#include <image_loader.h>
+#include <mapped_file.h>
+#include <mip_generator.h>
+#include <upload_ring.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Decodes image files on a pool of worker threads and uploads them on the render thread.
+// load() returns a texture name at once; until the image is in, that texture holds a 1x1 grey
+// placeholder, so it can be bound and drawn right away. pump() runs on the GL thread once per frame
+// and re-specifies finished textures in place, so the name handed out never changes.
+// Workers map the file and decode it straight into the mip chain's level 0 (ImageLoader), then build
+// the rest of the chain (MipGenerator). Every level is uploaded as it is, so the render thread never
+// runs glGenerateMipmap, which software and remote drivers do slowly on the CPU.
+// Files ending in .btex (tools/texture_baker.cpp) are mapped instead of decoded and carry their mip
+// chain already, so they cost a copy rather than an inflate and a filter pass. The worker faults the
+// mapping in, so the copy on the render thread never waits on the disk.
+// Uploads go through an UploadRing of pixel buffers and are capped by a byte budget per pump(), so
+// streaming textures in during gameplay never stalls a frame on a large synchronous copy.
+// Every queued load carries a ticket; unload() or a newer reload() of the same texture retires the
+// ticket and the stale image is dropped instead of uploaded, even if its worker finishes later.
+class TextureLoader
+{
+public:
+    // threads == 0 picks std::thread::hardware_concurrency()
+    explicit TextureLoader(unsigned int threads = 0) : Stop(false)
+    {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int i = 0; i < threads; i++)
+            Workers.emplace_back(&TextureLoader::work, this);
+    }
+
+    ~TextureLoader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Stop = true;
+        }
+        Wake.notify_all();
+        for (std::thread &worker : Workers)
+            worker.join();
+    }
+
+    TextureLoader(const TextureLoader &) = delete;
+    TextureLoader &operator=(const TextureLoader &) = delete;
+
+    // queue path for decoding and return its texture, which shows the placeholder until pump() uploads it.
+    // mips picks how the worker filters the mip chain, .btex files ignore it
+    GLuint load(const std::string &path, const MipOptions &mips = MipOptions())
+    {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        reload(texture, path, mips);
+        return texture;
+    }
+
+    // load path into an existing texture, which shows the placeholder again until pump() uploads it.
+    // A load still queued for texture is dropped
+    void reload(GLuint texture, const std::string &path, const MipOptions &mips = MipOptions())
+    {
+        const unsigned char placeholder[4] = {128, 128, 128, 255};
+        GLState::get().bindTextureForUpdate(0, GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+        uint64_t ticket = ++Tickets;
+        Pending[texture] = ticket;
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Jobs.push_back(Image{texture, ticket, path, mips, MipChain(), nullptr});
+        }
+        Wake.notify_one();
+    }
+
+    // drop a queued load of texture and delete it. GL thread only
+    void unload(GLuint texture)
+    {
+        Pending.erase(texture);
+        GLState::get().deleteTexture(texture);
+    }
+
+    // upload decoded images until budget bytes have been copied, returns how many textures became ready.
+    // The first image is uploaded whatever its size so a large texture cannot stall the queue; the rest
+    // wait for a later frame, as do images that find every pixel buffer still in use. GL thread only
+    size_t pump(size_t budget = DEFAULT_UPLOAD_BUDGET)
+    {
+        return uploadStaged(budget, false);
+    }
+
+    // block until every queued texture is uploaded, e.g. before taking a screenshot
+    void finish()
+    {
+        while (!Pending.empty())
+        {
+            if (Staged.empty())
+            {
+                std::unique_lock<std::mutex> lock(Mutex);
+                Done.wait(lock, [this]() { return !Decoded.empty(); });
+            }
+            uploadStaged(std::numeric_limits<size_t>::max(), true);
+        }
+    }
+
+    bool ready(GLuint texture) const
+    {
+        return Pending.find(texture) == Pending.end();
+    }
+
+    size_t pending() const
+    {
+        return Pending.size();
+    }
+
+    // bytes copied per pump() unless the caller passes its own budget
+    static const size_t DEFAULT_UPLOAD_BUDGET = 4 << 20;
+
+private:
+    struct Image
+    {
+        GLuint Texture;
+        uint64_t Ticket; // stale unless it is still Pending's ticket for Texture
+        std::string Path;
+        MipOptions Options;
+        MipChain Mips; // empty when decoding failed
+        std::unique_ptr<BakedTexture> Baked; // set instead of Mips for .btex files
+
+        size_t bytes() const
+        {
+            return Baked ? static_cast<size_t>(Baked->dataSize()) : Mips.Data.size();
+        }
+    };
+
+    std::vector<std::thread> Workers;
+    std::mutex Mutex;
+    std::condition_variable Wake; // a job was queued or the loader is shutting down
+    std::condition_variable Done; // an image was decoded
+    std::deque<Image> Jobs;
+    std::vector<Image> Decoded;
+    bool Stop;
+
+    // render thread only
+    std::deque<Image> Staged; // decoded, waiting for upload budget or a free pixel buffer
+    std::unordered_map<GLuint, uint64_t> Pending; // texture -> ticket of the load it waits for
+    uint64_t Tickets = 0;
+    UploadRing Ring;
+
+    void work()
+    {
+        for (;;)
+        {
+            Image image;
+            {
+                std::unique_lock<std::mutex> lock(Mutex);
+                Wake.wait(lock, [this]() { return Stop || !Jobs.empty(); });
+                if (Stop)
+                    return;
+                image = std::move(Jobs.front());
+                Jobs.pop_front();
+            }
+            if (isBaked(image.Path))
+            {
+                image.Baked.reset(new BakedTexture());
+                if (!image.Baked->open(image.Path))
+                    image.Baked.reset();
+                else
+                    image.Baked->prefault(); // the render thread copies it into a pixel buffer, without faults
+            }
+            else
+            {
+                // decode straight into level 0 of the chain, no stdio buffer or stb_image allocation in between
+                MappedFile file(image.Path);
+                ImageInfo info;
+                if (file.isOpen() && ImageLoader::info(file.data(), file.size(), info))
+                {
+                    image.Mips = MipGenerator::layout(info.Width, info.Height, info.Components);
+                    if (ImageLoader::decode(file.data(), file.size(), image.Mips.Data.data(), image.Mips.Levels[0].Size))
+                        MipGenerator::generate(image.Mips, image.Options);
+                    else
+                        image.Mips = MipChain();
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(Mutex);
+                Decoded.push_back(std::move(image));
+            }
+            Done.notify_one();
+        }
+    }
+
+    size_t uploadStaged(size_t budget, bool wait)
+    {
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            for (Image &image : Decoded)
+                Staged.push_back(std::move(image));
+            Decoded.clear();
+        }
+        size_t uploaded = 0, bytes = 0;
+        while (!Staged.empty())
+        {
+            Image &image = Staged.front();
+            auto pending = Pending.find(image.Texture);
+            if (pending == Pending.end() || pending->second != image.Ticket)
+            {
+                Staged.pop_front(); // unloaded or reloaded since, the texture may not even exist anymore
+                continue;
+            }
+            size_t size = image.bytes();
+            if (uploaded > 0 && bytes + size > budget)
+                break;
+            if (!upload(image, wait))
+                break;
+            Pending.erase(pending);
+            Staged.pop_front();
+            bytes += size;
+            uploaded++;
+        }
+        return uploaded;
+    }
+
+    // same texture setup the synchronous loader used: mipmapped, repeating. Returns false when no pixel
+    // buffer is free yet, wait blocks for one instead
+    bool upload(const Image &image, bool wait)
+    {
+        if (image.Mips.empty() && !image.Baked)
+        {
+            std::cout << "Texture failed to load at path: " << image.Path << std::endl;
+            return true;
+        }
+        if (image.Baked)
+        {
+            const BakedTextureHeader &header = image.Baked->header();
+            return uploadLevels(image.Texture, image.Baked->pixels(0), static_cast<size_t>(image.Baked->dataSize()), header.InternalFormat,
+                                header.Format, &image.Baked->level(0), header.Levels, image.Baked->level(0).Offset, wait);
+        }
+        const GLenum formats[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+        GLenum format = formats[image.Mips.Components - 1], internalFormat = format;
+        // filtered in linear light, so the GPU has to decode it when sampling too
+        if (image.Options.Srgb && image.Mips.Components >= 3)
+            internalFormat = image.Mips.Components == 4 ? GL_SRGB8_ALPHA8 : GL_SRGB8;
+        return uploadLevels(image.Texture, image.Mips.Data.data(), image.Mips.Data.size(), internalFormat, format, image.Mips.Levels.data(),
+                            image.Mips.Levels.size(), 0, wait);
+    }
+
+    // copy a whole mip chain into one pixel buffer and specify every level straight from it. Level is
+    // MipLevel or BakedTextureLevel, whose Offset is relative to base
+    template <typename Level>
+    bool uploadLevels(GLuint texture, const unsigned char *data, size_t size, GLenum internalFormat, GLenum format, const Level *levels,
+                      size_t count, uint64_t base, bool wait)
+    {
+        unsigned char *mapped = Ring.map(size, wait);
+        if (!mapped)
+            return false;
+        std::memcpy(mapped, data, size);
+        Ring.unmap();
+
+        GLState::get().bindTextureForUpdate(0, GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (size_t i = 0; i < count; i++)
+        {
+            // with a pixel unpack buffer bound the pointer is an offset into it
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), internalFormat, levels[i].Width, levels[i].Height, 0, format, GL_UNSIGNED_BYTE,
+                         (void *)static_cast<size_t>(levels[i].Offset - base));
+        }
+        Ring.submit();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(count) - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, count > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        return true;
+    }
+
+    static bool isBaked(const std::string &path)
+    {
+        return path.size() > 5 && path.compare(path.size() - 5, 5, ".btex") == 0;
+    }
+};
+#endif
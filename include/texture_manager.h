@@ -0,0 +1,332 @@
+#ifndef TEXTURE_MANAGER_H
+#define TEXTURE_MANAGER_H
+
+#include <glad/glad.h>
+
+#include <baked_texture.h>
+#include <hash.h>
+#include <image_loader.h>
+#include <mapped_file.h>
+#include <mip_generator.h>
+#include <texture_loader.h>
+
+#include <algorithm>
+#include <cstring>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class TextureManager;
+struct TextureEntry;
+
+// A counted reference to a texture owned by a TextureManager; the texture lives as long as any handle to
+// it does. get() returns the GL name to bind and counts as a use for the manager's LRU, so call it every
+// frame the texture is drawn rather than keeping the name: an evicted texture comes back under a new name.
+// The manager must outlive its handles. GL thread only
+class TextureHandle
+{
+public:
+    TextureHandle() = default;
+    TextureHandle(const TextureHandle &other);
+    TextureHandle(TextureHandle &&other) noexcept : Manager(other.Manager), Entry(other.Entry)
+    {
+        other.Manager = nullptr;
+        other.Entry = nullptr;
+    }
+    TextureHandle &operator=(TextureHandle other) noexcept
+    {
+        std::swap(Manager, other.Manager);
+        std::swap(Entry, other.Entry);
+        return *this;
+    }
+    ~TextureHandle();
+
+    // the texture to bind, reloaded first when it was evicted. 0 for an empty handle
+    GLuint get() const;
+
+    bool valid() const
+    {
+        return Entry != nullptr;
+    }
+
+private:
+    friend class TextureManager;
+    TextureHandle(TextureManager *manager, TextureEntry *entry);
+
+    TextureManager *Manager = nullptr;
+    TextureEntry *Entry = nullptr;
+};
+
+struct TextureEntry
+{
+    std::string Path; // loaded from, the first path seen with this content
+    MipOptions Options;
+    std::vector<std::string> Names; // keys in TextureManager::Paths that lead here
+    uint64_t Key = 0;
+    GLuint Texture = 0; // 0 while evicted
+    size_t Bytes = 0;   // estimated GPU memory, every mip level included
+    unsigned int Refs = 0;
+    unsigned int LastUsed = 0; // frame of the last get()
+    std::list<TextureEntry *>::iterator LruEntry; // valid while Texture != 0
+};
+
+// Owns every texture the scene loads. acquire() deduplicates on the file's content (and the mip options
+// it is filtered with), so two paths to the same image, or the same path twice, share one texture.
+// Each texture's GPU memory is estimated from its header, mip chain included, and the textures in memory
+// are kept on an LRU. pump() evicts from the cold end while the total is over the budget, which deletes
+// the GL texture but keeps the entry; the next get() queues it on the TextureLoader again and it shows the
+// placeholder until it is back. Textures used in the last frame are never evicted, so a scene that needs
+// more than the budget goes over it rather than reloading every frame.
+// An unreferenced texture stays cached until the budget needs its memory, then it is dropped for good.
+class TextureManager
+{
+public:
+    // threads is passed on to the TextureLoader, 0 picks std::thread::hardware_concurrency()
+    explicit TextureManager(size_t budget = DEFAULT_BUDGET, unsigned int threads = 0) : Loader(threads), Budget(budget)
+    {
+    }
+
+    ~TextureManager()
+    {
+        for (auto &entry : Entries)
+        {
+            if (entry.second.Texture)
+                Loader.unload(entry.second.Texture);
+        }
+    }
+
+    TextureManager(const TextureManager &) = delete;
+    TextureManager &operator=(const TextureManager &) = delete;
+
+    // the texture for path, queued for loading unless it is known already. A new path is mapped and hashed
+    // once on the calling thread, which costs about a millisecond per megabyte of file
+    TextureHandle acquire(const std::string &path, const MipOptions &mips = MipOptions())
+    {
+        std::string name = isBaked(path) ? path : path + optionsKey(mips);
+        auto known = Paths.find(name);
+        TextureEntry *entry;
+        if (known != Paths.end())
+            entry = &Entries[known->second];
+        else
+        {
+            size_t bytes = 0;
+            uint64_t key;
+            {
+                MappedFile file(path);
+                if (file.isOpen())
+                {
+                    key = fnv1a64(file.data(), file.size());
+                    bytes = estimate(file, path);
+                }
+                else
+                    key = fnv1a64(path.data(), path.size()); // still one entry, the loader reports the failure
+            }
+            if (!isBaked(path))
+            {
+                std::string options = optionsKey(mips);
+                key = fnv1a64(options.data(), options.size(), key);
+            }
+            entry = &Entries[key];
+            if (entry->Names.empty())
+            {
+                entry->Path = path;
+                entry->Options = mips;
+                entry->Key = key;
+                entry->Bytes = bytes;
+            }
+            entry->Names.push_back(name);
+            Paths[name] = key;
+        }
+        TextureHandle handle(this, entry);
+        use(*entry);
+        return handle;
+    }
+
+    // once per frame before drawing: evict down to the budget, then upload what finished decoding.
+    // Returns how many textures became ready
+    size_t pump(size_t uploadBudget = TextureLoader::DEFAULT_UPLOAD_BUDGET)
+    {
+        trim();
+        Frame++;
+        return Loader.pump(uploadBudget);
+    }
+
+    // block until every queued texture is uploaded
+    void finish()
+    {
+        Loader.finish();
+    }
+
+    // false while handle's texture still shows the placeholder, and while it is evicted
+    bool ready(const TextureHandle &handle) const
+    {
+        return handle.Entry && handle.Entry->Texture && Loader.ready(handle.Entry->Texture);
+    }
+
+    // takes effect at the next pump()
+    void setBudget(size_t bytes)
+    {
+        Budget = bytes;
+    }
+
+    size_t budget() const
+    {
+        return Budget;
+    }
+
+    // estimated GPU memory of the textures currently loaded or loading
+    size_t residentBytes() const
+    {
+        return Resident;
+    }
+
+    size_t count() const
+    {
+        return Entries.size();
+    }
+
+    size_t evictions() const
+    {
+        return Evictions;
+    }
+
+    // GPU memory of a full mip chain. Drivers pad 3 component texels to 4 bytes, so count them as 4
+    static size_t estimateBytes(int width, int height, int components, int levels)
+    {
+        size_t texel = components == 3 ? 4 : static_cast<size_t>(components), bytes = 0;
+        for (int i = 0; i < levels; i++)
+        {
+            bytes += static_cast<size_t>(width) * height * texel;
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        return bytes;
+    }
+
+    static const size_t DEFAULT_BUDGET = static_cast<size_t>(256) << 20;
+
+private:
+    friend class TextureHandle;
+
+    TextureLoader Loader;
+    std::unordered_map<uint64_t, TextureEntry> Entries; // by content and mip options
+    std::unordered_map<std::string, uint64_t> Paths;    // path and mip options -> key in Entries
+    std::list<TextureEntry *> Lru;                      // loaded textures, most recently used first
+    size_t Budget;
+    size_t Resident = 0;
+    size_t Evictions = 0;
+    unsigned int Frame = 0;
+
+    GLuint use(TextureEntry &entry)
+    {
+        if (!entry.Texture)
+        {
+            entry.Texture = Loader.load(entry.Path, entry.Options);
+            Resident += entry.Bytes;
+            Lru.push_front(&entry);
+            entry.LruEntry = Lru.begin();
+        }
+        else if (entry.LruEntry != Lru.begin())
+            Lru.splice(Lru.begin(), Lru, entry.LruEntry); // also after release() sent it to the back this frame
+        entry.LastUsed = Frame;
+        return entry.Texture;
+    }
+
+    void addRef(TextureEntry &entry)
+    {
+        entry.Refs++;
+    }
+
+    void release(TextureEntry &entry)
+    {
+        if (--entry.Refs > 0)
+            return;
+        if (!entry.Texture)
+            erase(entry);
+        else if (entry.Bytes == 0)
+            evict(entry); // failed to load, nothing worth caching
+        else
+            Lru.splice(Lru.end(), Lru, entry.LruEntry); // nothing can draw it anymore, first to go
+    }
+
+    void trim()
+    {
+        while (Resident > Budget && !Lru.empty())
+        {
+            TextureEntry &victim = *Lru.back();
+            if (victim.Refs > 0 && victim.LastUsed == Frame)
+                break; // drawn last frame, and so is everything before it on the list
+            evict(victim);
+        }
+    }
+
+    void evict(TextureEntry &entry)
+    {
+        Loader.unload(entry.Texture);
+        entry.Texture = 0;
+        Resident -= entry.Bytes;
+        Lru.erase(entry.LruEntry);
+        Evictions++;
+        if (entry.Refs == 0)
+            erase(entry);
+    }
+
+    void erase(TextureEntry &entry)
+    {
+        for (const std::string &name : entry.Names)
+            Paths.erase(name);
+        Entries.erase(entry.Key);
+    }
+
+    static size_t estimate(const MappedFile &file, const std::string &path)
+    {
+        if (isBaked(path))
+        {
+            const BakedTextureHeader *header = reinterpret_cast<const BakedTextureHeader *>(file.data());
+            if (file.size() < sizeof(BakedTextureHeader) || std::memcmp(header->Magic, "BTEX", 4) != 0)
+                return 0;
+            return estimateBytes(static_cast<int>(header->Width), static_cast<int>(header->Height), static_cast<int>(header->Components),
+                                 static_cast<int>(header->Levels));
+        }
+        ImageInfo info;
+        if (!ImageLoader::info(file.data(), file.size(), info))
+            return 0;
+        return estimateBytes(info.Width, info.Height, info.Components, MipGenerator::levelCount(info.Width, info.Height));
+    }
+
+    // the options that change the filtered pixels, Threads and Vectorize do not
+    static std::string optionsKey(const MipOptions &mips)
+    {
+        return "|" + std::to_string(static_cast<int>(mips.Filter)) + (mips.Srgb ? "s" : "l") + std::to_string(mips.AlphaCutoff);
+    }
+
+    static bool isBaked(const std::string &path)
+    {
+        return path.size() > 5 && path.compare(path.size() - 5, 5, ".btex") == 0;
+    }
+};
+
+inline TextureHandle::TextureHandle(TextureManager *manager, TextureEntry *entry) : Manager(manager), Entry(entry)
+{
+    Manager->addRef(*Entry);
+}
+
+inline TextureHandle::TextureHandle(const TextureHandle &other) : Manager(other.Manager), Entry(other.Entry)
+{
+    if (Entry)
+        Manager->addRef(*Entry);
+}
+
+inline TextureHandle::~TextureHandle()
+{
+    if (Entry)
+        Manager->release(*Entry);
+}
+
+inline GLuint TextureHandle::get() const
+{
+    return Entry ? Manager->use(*Entry) : 0;
+}
+#endif
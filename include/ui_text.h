@@ -6,200 +6,937 @@
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include FT_MODULE_H
+#include FT_SIZES_H
 
 #include <shader.h>
+#include <gl_state.h>
+#include <glyph_atlas.h>
+#include <glyph_rasterizer.h>
+#include <baked_font.h>
+#include <font_manager.h>
+#include <text_batcher.h>
+#include <text_instancer.h>
 
+#include <utf8.h>
+
+#include <algorithm>
 #include <string>
-#include <map>
+#include <vector>
+#include <list>
+#include <memory>
+#include <cmath>
+#include <unordered_map>
+#include <cstdint>
+#include <limits>
+#include <iostream>
 
 struct Character
 {
-    GLuint TextureID;   // 字形纹理的ID
+    glm::vec4 UV;       // 字形在图集中的纹理坐标 (u0, v0, u1, v1)
     glm::ivec2 Size;    // 字形大小
     glm::ivec2 Bearing; // 从基准线到字形左部/顶部的偏移值
     GLint Advance;      // 原点距下一个字形原点的距离
 };
 
+// TEXT_BITMAP: 覆盖率位图，按请求的字号选最接近的光栅化字号，小字也清晰，配合text.fs
+// TEXT_SDF: 用FreeType的sdf模块生成有向距离场，一张小图集就能清晰地绘制任意字号，配合sdf_text.fs
+enum TextRenderMode
+{
+    TEXT_BITMAP,
+    TEXT_SDF,
+};
+
+// 段落的对齐方式。wrapWidth大于0时相对于[x, x + wrapWidth]这个框，否则相对于x这一点
+enum TextAlign
+{
+    TEXT_ALIGN_LEFT,
+    TEXT_ALIGN_CENTER,
+    TEXT_ALIGN_RIGHT,
+};
+
+// 断行的结果：一行对应文本里的字节范围[Begin, End)，不包括行尾的空白和换行符
+struct TextLine
+{
+    uint32_t Begin, End;
+    GLfloat Width; // scale为1时的宽度
+};
+
+// 文字的四边形先由drawText收集到TextBatcher里，每帧调用一次flush()统一绘制。
+// 文本按UTF-8解码，字形在第一次用到时才由FreeType光栅化并放进图集；图集满了以后
+// 按LRU淘汰当前帧没有用到的字形，所以启动开销与字体覆盖多少字符无关。
+// 字形缓存的键是(字体, 字号档位, 码位)：位图模式下每个scale选最接近的档位光栅化，所有字体和字号
+// 共用一张图集和一条LRU，所以不同字号的文字仍然在同一次绘制里，显存也有上限。
+// 图集按高度档位分行放字形(见GlyphAtlas)，淘汰小字号腾出的空间会合并，也能放下大字号；
+// 空闲空间够却被这一帧的字形切碎时，flush()在帧末清空图集，字形用到时再放回去。
+// 每帧都在变的文字(计数器、表格)可以用drawDynamicText()走实例化路径，CPU只提交笔位置和字形表的下标。
+// 已知会用到的字符可以用preload()在多个线程上预先光栅化，避免第一次绘制时卡顿。
+// 字体由FontManager按FontStyle懒加载，映射和face在所有UiText之间共享。
+// 给出FontBaker烘焙好的字体文件(常规体)时，图集直接从内存映射上传，只有不在烘焙集合里的字形才会用到FreeType
 class UiText
 {
 public:
-    unsigned int VAO;
+    // scale为1时字高48像素，两种模式一致。bakedPath为空或者文件与mode不匹配时全部字形都由FreeType生成
+    UiText(TextRenderMode mode = TEXT_BITMAP, const std::string &bakedPath = "")
+        : Mode(mode),
+          Atlas(mode == TEXT_SDF ? 512 : 1024, mode == TEXT_SDF ? 512 : 1024)
+    {
+        // 距离场向字形外扩展的像素数(SDF_SPREAD)决定了放大时描边的平滑范围。
+        // FreeType的字体要等到第一个不在烘焙集合里的字形才打开
+        if (!bakedPath.empty())
+            loadBaked(bakedPath);
+    }
 
-    UiText()
+    ~UiText()
     {
-        FT_Library ft;
-        if (FT_Init_FreeType(&ft))
-            std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+        // face属于FontManager，这里只释放自己创建的FT_Size
+        for (std::unique_ptr<Strike> &st : Strikes)
+        {
+            if (st->Size)
+                FT_Done_Size(st->Size);
+        }
+    }
 
-        FT_Face face;
-        if (FT_New_Face(ft, "resources/fonts/arial.ttf", 0, &face))
-            std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
+    UiText(const UiText &) = delete;
+    UiText &operator=(const UiText &) = delete;
 
-        FT_Set_Pixel_Sizes(face, 0, 48);
+    // 只收集四边形，真正的绘制在flush()里
+    void drawText(Shader &s, const std::string &text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color, FontStyle style = FONT_REGULAR)
+    {
+        layoutText(text, x, y, scale, color, 0.0f, TEXT_ALIGN_LEFT, Batcher.vertices(s, Atlas.TextureID), style);
+    }
 
-        if (FT_Load_Char(face, 'X', FT_LOAD_RENDER))
-            std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
+    // 在宽width的框里按单词换行，(x, y)是第一行的基准线起点。id不为0时断行结果按id缓存(见cachedBreaks)，
+    // 每帧都画的长段落应该给一个id
+    void drawParagraph(Shader &s, const std::string &text, GLfloat x, GLfloat y, GLfloat width, GLfloat scale, glm::vec3 color, TextAlign align = TEXT_ALIGN_LEFT, FontStyle style = FONT_REGULAR, uint64_t id = 0)
+    {
+        std::vector<TextVertex> &out = Batcher.vertices(s, Atlas.TextureID);
+        if (id == 0)
+            layoutText(text, x, y, scale, color, width, align, out, style);
+        else
+            layoutLines(text, cachedBreaks(id, text, width, scale, style), x, y, scale, color, width, align, out, style);
+    }
 
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); //禁用字节对齐限制
-        for (GLubyte c = 0; c < 128; c++)
+    // 把文本排版成四边形追加到out里(每个字形4个顶点)。'\n'总是换行，wrapWidth大于0时还会在单词边界换行。
+    // 顶点里的UV在图集淘汰字形后会失效，保存结果的一方要用pinGlyphs()固定用到的字形并留意generation()
+    void layoutText(const std::string &text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color, GLfloat wrapWidth, TextAlign align, std::vector<TextVertex> &out, FontStyle style = FONT_REGULAR)
+    {
+        Lines.clear();
+        breakLines(text, wrapWidth, scale, style, Lines);
+        layoutLines(text, Lines, x, y, scale, color, wrapWidth, align, out, style);
+    }
+
+    // 按已经断好的行排版，lines来自breakLines(text, wrapWidth, scale, style)。保存了断行结果的一方
+    // (比如TextLayout)重新排版时不需要再断行。glyphs不为空时追加用到的字形的键，交给pinGlyphs()
+    void layoutLines(const std::string &text, const std::vector<TextLine> &lines, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color, GLfloat wrapWidth, TextAlign align, std::vector<TextVertex> &out, FontStyle style = FONT_REGULAR, std::vector<uint64_t> *glyphs = nullptr)
+    {
+        GLfloat advance = lineHeight(scale, style);
+        GLfloat tempY = y;
+        for (const TextLine &line : lines)
         {
-            // 加载字符的字形
-            if (FT_Load_Char(face, c, FT_LOAD_RENDER))
-            {
-                std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-                continue;
-            }
-            // 生成纹理
-            GLuint texture;
-            glGenTextures(1, &texture);
-            glBindTexture(GL_TEXTURE_2D, texture);
-            glTexImage2D(
-                GL_TEXTURE_2D,
-                0,
-                GL_RED,
-                face->glyph->bitmap.width,
-                face->glyph->bitmap.rows,
-                0,
-                GL_RED,
-                GL_UNSIGNED_BYTE,
-                face->glyph->bitmap.buffer);
-
-            // 设置纹理选项
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            // 储存字符供之后使用
-            Character character = {
-                texture,
-                glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-                glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-                face->glyph->advance.x};
-            Characters.insert(std::pair<GLchar, Character>(c, character));
-        }
-        glBindTexture(GL_TEXTURE_2D, 0);
-
-        FT_Done_Face(face);
-        FT_Done_FreeType(ft);
-
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 5, NULL, GL_DYNAMIC_DRAW);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void *)0);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (void *)(3 * sizeof(GLfloat)));
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
-    }
-
-    void drawText(Shader &s, std::string text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color)
-    {
-        // 激活对应的渲染状态
-        s.use();
-        s.setVec3("textColor", color.x, color.y, color.z);
-        glm::mat4 projection = glm::ortho(0.0f, static_cast<GLfloat>(1920), 0.0f, static_cast<GLfloat>(1080));
-        glm::mat4 model = glm::mat4(1.0f);
-        glm::mat4 view = glm::mat4(1.0f);
-        s.setMat4("projection", projection);
-        s.setMat4("model", model);
-        s.setMat4("view", view);
-        glActiveTexture(GL_TEXTURE0);
-        glBindVertexArray(VAO);
-
-        // 遍历文本中所有的字符
-        std::string::const_iterator c;
-        for (c = text.begin(); c != text.end(); c++)
-        {
-            Character ch = Characters[*c];
-            GLfloat xpos = x + ch.Bearing.x * scale;
+            GLfloat width = line.Width * scale;
+            GLfloat tempX = x;
+            if (align == TEXT_ALIGN_CENTER)
+                tempX += wrapWidth > 0.0f ? (wrapWidth - width) * 0.5f : -width * 0.5f;
+            else if (align == TEXT_ALIGN_RIGHT)
+                tempX += wrapWidth > 0.0f ? wrapWidth - width : -width;
+            layoutRange(text.data() + line.Begin, text.data() + line.End, tempX, tempY, scale, color, out, 0.0f, style, glyphs);
+            tempY -= advance;
+        }
+    }
+
+    // 在单词边界断行，只遍历一次文本，结果追加到out里。保存结果的一方(比如TextLayout)在文本、宽度和字号档位
+    // 都没变时直接复用，不用再断行
+    void breakLines(const std::string &text, GLfloat wrapWidth, GLfloat scale, FontStyle style, std::vector<TextLine> &out)
+    {
+        breakRange(text.data(), text.data() + text.size(), wrapWidth, scale, out, style);
+    }
+
+    // 按调用方给的id缓存的断行结果。id代表段落的内容，文本变了要换一个id(比如带上版本号)，命中时只有一次
+    // 哈希查找，与文本长度无关；宽度或字号档位变了会重新断行。缓存的总行数超过BREAK_CACHE_LINES时淘汰最久没用的段落。
+    // 返回的引用在下一次调用之前有效
+    const std::vector<TextLine> &cachedBreaks(uint64_t id, const std::string &text, GLfloat wrapWidth, GLfloat scale, FontStyle style = FONT_REGULAR)
+    {
+        Strike &st = strikeFor(scale, style);
+        prepareMetrics(st);
+        GLfloat limit = breakLimit(st, wrapWidth, scale);
+        auto it = BreakCache.find(id);
+        if (it != BreakCache.end())
+        {
+            BreakLru.splice(BreakLru.begin(), BreakLru, it->second.LruEntry);
+            if (it->second.Strike == st.Index && it->second.Limit == limit)
+                return it->second.Lines;
+        }
+        else
+        {
+            BreakLru.push_front(id);
+            it = BreakCache.emplace(id, CachedBreaks()).first;
+            it->second.LruEntry = BreakLru.begin();
+        }
+        CachedBreaks &cached = it->second;
+        cached.Strike = st.Index;
+        cached.Limit = limit;
+        BreakCacheLines -= cached.Lines.size();
+        cached.Lines.clear();
+        computeBreaks(st, text.data(), text.data() + text.size(), limit, cached.Lines);
+        BreakCacheLines += cached.Lines.size();
+        // 这一段在最前面，不会淘汰到它自己
+        while (BreakCacheLines > BREAK_CACHE_LINES && BreakLru.back() != id)
+        {
+            auto victim = BreakCache.find(BreakLru.back());
+            BreakCacheLines -= victim->second.Lines.size();
+            BreakCache.erase(victim);
+            BreakLru.pop_back();
+        }
+        return cached.Lines;
+    }
+
+    // 不经过缓存地断行[begin, end)，TextLine里的偏移相对于begin。给自己管理文本存储的一方(比如TextView)用
+    void breakRange(const char *begin, const char *end, GLfloat wrapWidth, GLfloat scale, std::vector<TextLine> &out, FontStyle style = FONT_REGULAR)
+    {
+        Strike &st = strikeFor(scale, style);
+        prepareMetrics(st);
+        computeBreaks(st, begin, end, breakLimit(st, wrapWidth, scale), out);
+    }
+
+    // 把[c, end)排成一行，不处理换行，(x, y)是基准线起点。clipWidth大于0时超出x + clipWidth的部分不排
+    void layoutRange(const char *c, const char *end, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color, std::vector<TextVertex> &out, GLfloat clipWidth = 0.0f, FontStyle style = FONT_REGULAR, std::vector<uint64_t> *glyphs = nullptr)
+    {
+        Strike &st = strikeFor(scale, style);
+        prepareMetrics(st);
+        GLfloat clipX = clipWidth > 0.0f ? x + clipWidth : std::numeric_limits<GLfloat>::max();
+        GLfloat tempX = x;
+        // 字形度量是按光栅化字号存的，换算到48像素基准
+        scale *= st.MetricScale;
+        uint32_t previous = 0;
+
+        // 遍历这一行中所有的字符
+        while (c != end)
+        {
+            uint32_t codepoint = decodeUtf8(c, end);
+            const Character &ch = glyph(st, codepoint).Metrics;
+            tempX += (kerning(st, previous, codepoint) >> 6) * scale;
+            previous = codepoint;
+            GLfloat xpos = tempX + ch.Bearing.x * scale;
             GLfloat ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
+            if (xpos >= clipX)
+                break;
+            if (glyphs)
+                glyphs->push_back(lruKey(st, codepoint));
 
             GLfloat w = ch.Size.x * scale;
             GLfloat h = ch.Size.y * scale;
-            // 对每个字符更新VBO
-            GLfloat vertices[6][5] = {
-                {xpos, ypos + h, 0.0, 0.0, 0.0},
-                {xpos, ypos, 0.0, 0.0, 1.0},
-                {xpos + w, ypos, 0.0, 1.0, 1.0},
-
-                {xpos, ypos + h, 0.0, 0.0, 0.0},
-                {xpos + w, ypos, 0.0, 1.0, 1.0},
-                {xpos + w, ypos + h, 0.0, 1.0, 0.0}};
-            // 在四边形上绘制字形纹理
-            glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-            // 更新VBO内存的内容
-            glBindBuffer(GL_ARRAY_BUFFER, VBO);
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-            // 绘制四边形
-            glDrawArrays(GL_TRIANGLES, 0, 6);
+            // 把字形的四边形加入批次，颜色随顶点传递
+            if (ch.Size.x > 0)
+                TextBatcher::appendQuad(out, xpos, ypos, w, h, ch.UV, color);
             // 更新位置到下一个字形的原点，注意单位是1/64像素
-            x += (ch.Advance >> 6) * scale; // 位偏移6个单位来获取单位为像素的值 (2^6 = 64)
+            tempX += (ch.Advance >> 6) * scale; // 位偏移6个单位来获取单位为像素的值 (2^6 = 64)
+        }
+    }
+
+    // 固定keys里的字形，keys来自layoutLines/layoutRange的glyphs参数，会被排序去重。固定的字形不会被淘汰，
+    // 所以保存了顶点的一方(TextLayout、TextView)不会因为别处的字形被淘汰而重新排版，只需要留意generation()。
+    // 返回false表示有字形没能放进图集，这时等evictions()变化(腾出了空间)再重排。固定次数按键计数，可以跨越图集清空
+    bool pinGlyphs(std::vector<uint64_t> &keys)
+    {
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        bool resident = true;
+        for (uint64_t key : keys)
+        {
+            Pins[key]++;
+            if (!findGlyph(*Strikes[key >> 32], static_cast<uint32_t>(key)))
+                resident = false;
         }
-        glBindVertexArray(0);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        return resident;
     }
 
-    void drawTextResizeHeight(Shader &s, std::string text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color)
+    // 撤销一次pinGlyphs(keys)
+    void unpinGlyphs(const std::vector<uint64_t> &keys)
     {
-        // 激活对应的渲染状态
-        s.use();
-        s.setVec3("textColor", color.x, color.y, color.z);
-        glm::mat4 projection = glm::ortho(0.0f, static_cast<GLfloat>(800), 0.0f, static_cast<GLfloat>(600));
-        glm::mat4 model = glm::mat4(1.0f);
-        glm::mat4 view = glm::mat4(1.0f);
-        s.setMat4("projection", projection);
-        s.setMat4("model", model);
-        s.setMat4("view", view);
-        glActiveTexture(GL_TEXTURE0);
-        glBindVertexArray(VAO);
+        for (uint64_t key : keys)
+        {
+            auto it = Pins.find(key);
+            if (it != Pins.end() && --it->second == 0)
+                Pins.erase(it);
+        }
+    }
 
-        GLfloat tempX = x, tempY = y;
+    // 与drawText一样排版，但每个字形只收集一个GlyphInstance，四边形由顶点着色器从字形表展开。
+    // s要用text_instanced.vs，片段着色器与drawText相同(text.fs或sdf_text.fs)
+    void drawDynamicText(Shader &s, const std::string &text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color, FontStyle style = FONT_REGULAR)
+    {
+        layoutInstances(text, x, y, scale, color, Instancer.instances(s, Atlas.TextureID), style);
+    }
 
-        // 遍历文本中所有的字符
-        std::string::const_iterator c;
-        for (c = text.begin(); c != text.end(); c++)
+    // 把文本排成GlyphInstance追加到out里，'\n'换行，不自动换行。实例里的字形表下标在字形被淘汰后会失效
+    void layoutInstances(const std::string &text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color, std::vector<GlyphInstance> &out, FontStyle style = FONT_REGULAR)
+    {
+        Strike &st = strikeFor(scale, style);
+        prepareMetrics(st);
+        scale *= st.MetricScale;
+        GLfloat lineAdvance = (st.LineHeight >> 6) * scale;
+        GLubyte r = TextBatcher::toByte(color.x), g = TextBatcher::toByte(color.y), b = TextBatcher::toByte(color.z);
+        GLfloat tempX = x;
+        uint32_t previous = 0;
+        const char *c = text.data(), *end = text.data() + text.size();
+        while (c != end)
         {
-            Character ch = Characters[*c];
-            if (tempX + ch.Bearing.x * scale > x + 100)
+            uint32_t codepoint = decodeUtf8(c, end);
+            if (codepoint == '\n')
             {
                 tempX = x;
-                tempY -= 48 * scale;
+                y -= lineAdvance;
+                previous = 0;
+                continue;
             }
-            GLfloat xpos = tempX + ch.Bearing.x * scale;
-            GLfloat ypos = tempY - (ch.Size.y - ch.Bearing.y) * scale;
+            const CachedGlyph &cached = glyph(st, codepoint);
+            tempX += (kerning(st, previous, codepoint) >> 6) * scale;
+            previous = codepoint;
+            // 字形表里的四边形相对于笔位置，这里只剩下步进和字距
+            if (cached.Metrics.Size.x > 0)
+                out.push_back(GlyphInstance{tempX, y, scale, cached.Entry, r, g, b, 255});
+            tempX += (cached.Metrics.Advance >> 6) * scale;
+        }
+    }
 
-            GLfloat w = ch.Size.x * scale;
-            GLfloat h = ch.Size.y * scale;
-            // 对每个字符更新VBO
-            GLfloat vertices[6][5] = {
-                {xpos, ypos + h, 0.0, 0.0, 0.0},
-                {xpos, ypos, 0.0, 0.0, 1.0},
-                {xpos + w, ypos, 0.0, 1.0, 1.0},
-
-                {xpos, ypos + h, 0.0, 0.0, 0.0},
-                {xpos + w, ypos, 0.0, 1.0, 1.0},
-                {xpos + w, ypos + h, 0.0, 1.0, 0.0}};
-            // 在四边形上绘制字形纹理
-            glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-            // 更新VBO内存的内容
-            glBindBuffer(GL_ARRAY_BUFFER, VBO);
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-            // 绘制四边形
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-            // 更新位置到下一个字形的原点，注意单位是1/64像素
-            tempX += (ch.Advance >> 6) * scale; // 位偏移6个单位来获取单位为像素的值 (2^6 = 64)
+    // 行距，取自字体的度量(ascender - descender + line gap)
+    GLfloat lineHeight(GLfloat scale, FontStyle style = FONT_REGULAR)
+    {
+        Strike &st = strikeFor(scale, style);
+        prepareMetrics(st);
+        return (st.LineHeight >> 6) * st.MetricScale * scale;
+    }
+
+    // 基准线以下的深度(正值)
+    GLfloat descender(GLfloat scale, FontStyle style = FONT_REGULAR)
+    {
+        Strike &st = strikeFor(scale, style);
+        prepareMetrics(st);
+        return (-st.Descender >> 6) * st.MetricScale * scale;
+    }
+
+    // 文本排成一行时的宽度和行距，与layoutText的排版结果一致。
+    // 只用字形的步进和字距表，不光栅化也不碰GL，码位的步进第一次查到之后就不再分配内存
+    glm::vec2 measure(const std::string &text, GLfloat scale, FontStyle style = FONT_REGULAR)
+    {
+        Strike &st = strikeFor(scale, style);
+        prepareMetrics(st);
+        GLint width = 0; // 光栅化字号下的整像素
+        uint32_t previous = 0;
+        const char *c = text.data(), *end = text.data() + text.size();
+        while (c != end)
+        {
+            uint32_t codepoint = decodeUtf8(c, end);
+            width += (kerning(st, previous, codepoint) >> 6) + (advance(st, codepoint) >> 6);
+            previous = codepoint;
         }
-        glBindVertexArray(0);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        return glm::vec2(width * scale * st.MetricScale, lineHeight(scale, style));
+    }
+
+    // 用threads个线程(0表示按CPU核数)预先光栅化style在scale对应字号下的codepoints，每个线程有自己的FT_Library和FT_Face，
+    // 位图先放在暂存区里，最后在调用线程(GL线程)上统一上传到图集。已经缓存的码位会被跳过
+    void preload(const std::vector<uint32_t> &codepoints, unsigned int threads = 0, GLfloat scale = 1.0f, FontStyle style = FONT_REGULAR)
+    {
+        Strike &st = strikeFor(scale, style);
+        std::vector<uint32_t> pending;
+        for (uint32_t codepoint : codepoints)
+        {
+            if (findGlyph(st, codepoint))
+                continue;
+            const BakedGlyph *baked = st.Baked ? st.Baked->find(codepoint) : nullptr;
+            if (!baked)
+                pending.push_back(codepoint);
+            else if (!insertBaked(st, *baked))
+                return;
+        }
+        std::vector<RasterizedGlyph> staged = GlyphRasterizer::rasterize(options(st), pending, threads);
+        for (const RasterizedGlyph &g : staged)
+        {
+            if (!g.Loaded || findGlyph(st, g.Codepoint))
+                continue;
+            Character character = {glm::vec4(0.0f), glm::ivec2(g.Width, g.Height), glm::ivec2(g.Left, g.Top), static_cast<GLint>(g.Advance)};
+            if (!insertGlyph(st, g.Codepoint, character, g.Pixels.data(), g.Width))
+                break;
+        }
+    }
+
+    TextRenderMode mode() const
+    {
+        return Mode;
+    }
+
+    // scale实际使用的光栅化字号
+    int pixelSize(GLfloat scale, FontStyle style = FONT_REGULAR)
+    {
+        return strikeFor(scale, style).PixelSize;
+    }
+
+    GLuint atlasTexture() const
+    {
+        return Atlas.TextureID;
+    }
+
+    // 图集清空重排(见flush)时递增，这时所有字形都换了位置，固定的也不例外
+    unsigned int generation() const
+    {
+        return Atlas.Generation;
+    }
+
+    // 淘汰过的字形数
+    unsigned int evictions() const
+    {
+        return Evictions;
+    }
+
+    // 绘制这一帧收集到的所有文字，投影和视图矩阵来自当前绑定的FrameData记录
+    void flush()
+    {
+        Batcher.flush();
+        Table.upload();
+        Instancer.flush(Table);
+        // 这一帧的文字都已经提交，现在移动字形不会让排好的顶点指错位置
+        if (RepackPending)
+            resetAtlas();
+        Frame++;
     }
 
 private:
-    unsigned int VBO;
-    std::map<GLchar, Character> Characters;
+    struct CachedGlyph
+    {
+        Character Metrics;
+        glm::ivec4 Slot;                        // 图集中占用的位置，淘汰时归还
+        std::list<uint64_t>::iterator LruEntry; // 在Lru中的位置
+        unsigned int LastUsed;                  // 最后一次被使用的帧
+        bool Resident;                          // 只对FlatGlyphs有意义，哈希表里的都在图集中
+        GLuint Entry;                           // 在字形表里的下标，只有非空的字形才有
+    };
+
+    // ASCII和Latin-1按码位直接索引，其余的码位放在哈希表里
+    static const uint32_t FLAT_GLYPHS = 256;
+
+    // 一个字体在一个字号档位下的全部缓存(排版里叫strike)：字形、步进、字距和行距
+    struct Strike
+    {
+        uint32_t Index;      // 在Strikes里的位置，也是LRU键的高32位
+        FontStyle Style;
+        int PixelSize;       // 字形光栅化时的字号
+        GLfloat MetricScale; // 48 / PixelSize
+        FT_Size Size = nullptr;           // face上这个字号的尺寸对象
+        const BakedFont *Baked = nullptr; // 与这个字号匹配的烘焙文件
+        std::vector<CachedGlyph> FlatGlyphs = std::vector<CachedGlyph>(FLAT_GLYPHS, CachedGlyph{});
+        std::unordered_map<uint32_t, CachedGlyph> Glyphs;
+        // 步进(1/64像素)与图集无关，淘汰字形后仍然保留，供measure()使用；-1表示还没查过
+        std::vector<GLint> FlatAdvances = std::vector<GLint>(FLAT_GLYPHS, -1);
+        std::unordered_map<uint32_t, GLint> Advances;
+        bool MetricsReady = false;
+        GLint LineHeight = 0; // 1/64像素
+        GLint Descender = 0;  // 1/64像素，负值
+        // 字距表，键为(左码位 << 32 | 右码位)；FlatKerns标记哪些左码位有字距，省掉大部分哈希查找
+        std::unordered_map<uint64_t, GLint> Kerning;
+        std::vector<unsigned char> FlatKerns = std::vector<unsigned char>(FLAT_GLYPHS, 0);
+        bool OtherKerns = false;
+    };
+
+    struct CachedBreaks
+    {
+        uint32_t Strike;
+        GLfloat Limit;
+        std::vector<TextLine> Lines;
+        std::list<uint64_t>::iterator LruEntry; // 在BreakLru中的位置
+    };
+
+    // 位图模式的字号档位，scale为1对应48像素
+    static constexpr int SIZE_BUCKETS[] = {12, 16, 20, 24, 32, 48, 64, 96};
+    static const int SDF_PIXEL_SIZE = 32;
+    static const int SDF_SPREAD = 6;
+    static const size_t BREAK_CACHE_LINES = 1 << 16; // 12字节一行，约768KB
+
+    TextRenderMode Mode;
+    std::vector<std::unique_ptr<Strike>> Strikes;
+    Strike *LastStrike = nullptr; // 上一次strikeFor的结果，同一scale连续调用时不用再找
+    GLfloat LastScale = 0.0f;
+    BakedFont Baked;
+    GlyphAtlas Atlas;
+    TextBatcher Batcher;
+    GlyphTable Table;
+    TextInstancer Instancer;
+    std::list<uint64_t> Lru; // 最近使用的在前，键为(strike << 32 | 码位)
+    std::unordered_map<uint64_t, CachedBreaks> BreakCache; // 键为cachedBreaks的id
+    std::list<uint64_t> BreakLru;                          // 最近用过的段落在前
+    size_t BreakCacheLines = 0;                            // BreakCache里的总行数
+    std::vector<TextLine> Lines;                           // layoutText的断行结果，复用分配
+    std::unordered_map<uint64_t, unsigned int> Pins; // pinGlyphs()固定的字形和次数，键与Lru相同
+    unsigned int Frame = 0;
+    unsigned int Evictions = 0;
+    bool RepackPending = false; // 图集空间够但被切碎了，帧末清空重来
+    CachedGlyph Missing = CachedGlyph{Character{glm::vec4(0.0f), glm::ivec2(0), glm::ivec2(0), 0}, glm::ivec4(0), Lru.end(), 0, false, 0};
+    RasterizedGlyph Scratch; // 懒加载时复用的位图缓冲
+
+    // 请求的字号是48 * scale，选对数距离最近的档位；距离场可以任意缩放，只用一个字号
+    int bucketFor(GLfloat scale) const
+    {
+        if (Mode == TEXT_SDF)
+            return SDF_PIXEL_SIZE;
+        GLfloat wanted = std::log(std::max(48.0f * scale, 1.0f));
+        int best = SIZE_BUCKETS[0];
+        for (int size : SIZE_BUCKETS)
+        {
+            if (std::fabs(std::log(static_cast<GLfloat>(size)) - wanted) < std::fabs(std::log(static_cast<GLfloat>(best)) - wanted))
+                best = size;
+        }
+        return best;
+    }
+
+    Strike &strikeFor(GLfloat scale, FontStyle style)
+    {
+        if (LastStrike && LastScale == scale && LastStrike->Style == style)
+            return *LastStrike;
+        LastScale = scale;
+        LastStrike = &strike(style, bucketFor(scale));
+        return *LastStrike;
+    }
+
+    Strike &strike(FontStyle style, int pixelSize)
+    {
+        for (std::unique_ptr<Strike> &st : Strikes)
+        {
+            if (st->Style == style && st->PixelSize == pixelSize)
+                return *st;
+        }
+        Strikes.emplace_back(new Strike());
+        Strike &st = *Strikes.back();
+        st.Index = static_cast<uint32_t>(Strikes.size() - 1);
+        st.Style = style;
+        st.PixelSize = pixelSize;
+        st.MetricScale = 48.0f / pixelSize;
+        return st;
+    }
+
+    // 工作线程从FontManager的映射打开自己的face，不再读一遍文件
+    RasterizerOptions options(const Strike &st) const
+    {
+        RasterizerOptions options{FontManager::path(st.Style), st.PixelSize, Mode == TEXT_SDF, SDF_SPREAD};
+        if (const MappedFile *file = FontManager::get().file(st.Style))
+        {
+            options.FontData = file->data();
+            options.FontSize = file->size();
+        }
+        return options;
+    }
+
+    // 取得strike的字体并切换到它的字号，失败时返回nullptr
+    FT_Face activate(Strike &st)
+    {
+        FT_Face face = FontManager::get().face(st.Style);
+        if (!face)
+            return nullptr;
+        if (!st.Size)
+        {
+            // 同一个face上每个字号一个FT_Size，切换字号不需要重新设置
+            if (FT_New_Size(face, &st.Size))
+                return nullptr;
+            FT_Activate_Size(st.Size);
+            FT_Set_Pixel_Sizes(face, 0, st.PixelSize);
+            if (Mode == TEXT_SDF)
+            {
+                FT_UInt spread = SDF_SPREAD;
+                FT_Property_Set(FontManager::get().library(), "sdf", "spread", &spread);
+            }
+        }
+        else
+            FT_Activate_Size(st.Size);
+        return face;
+    }
+
+    // 取得码位对应的字形，不在缓存里就现场光栅化
+    const CachedGlyph &glyph(Strike &st, uint32_t codepoint)
+    {
+        if (CachedGlyph *cached = findGlyph(st, codepoint))
+        {
+            if (cached->LastUsed != Frame)
+            {
+                cached->LastUsed = Frame;
+                Lru.splice(Lru.begin(), Lru, cached->LruEntry);
+            }
+            return *cached;
+        }
+
+        // 烘焙过的字形被淘汰后直接从映射里重新拷贝
+        if (const BakedGlyph *baked = st.Baked ? st.Baked->find(codepoint) : nullptr)
+        {
+            if (!insertBaked(st, *baked))
+            {
+                Missing.Metrics.Advance = baked->Advance;
+                return Missing;
+            }
+            return *findGlyph(st, codepoint);
+        }
+
+        Missing.Metrics.Advance = 0;
+        FT_Face face = activate(st);
+        if (!face)
+            return Missing;
+        RasterizedGlyph &g = Scratch;
+        GlyphRasterizer::render(options(st), face, codepoint, g);
+        if (!g.Loaded)
+        {
+            std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
+            return Missing;
+        }
+        Character character = {glm::vec4(0.0f), glm::ivec2(g.Width, g.Height), glm::ivec2(g.Left, g.Top), static_cast<GLint>(g.Advance)};
+        if (!insertGlyph(st, codepoint, character, g.Pixels.data(), g.Width))
+        {
+            Missing.Metrics.Advance = character.Advance;
+            return Missing;
+        }
+        return *findGlyph(st, codepoint);
+    }
+
+    static uint64_t lruKey(const Strike &st, uint32_t codepoint)
+    {
+        return (static_cast<uint64_t>(st.Index) << 32) | codepoint;
+    }
+
+    CachedGlyph *findGlyph(Strike &st, uint32_t codepoint)
+    {
+        if (codepoint < FLAT_GLYPHS)
+            return st.FlatGlyphs[codepoint].Resident ? &st.FlatGlyphs[codepoint] : nullptr;
+        auto it = st.Glyphs.find(codepoint);
+        return it != st.Glyphs.end() ? &it->second : nullptr;
+    }
+
+    void storeGlyph(Strike &st, uint32_t codepoint, CachedGlyph cached)
+    {
+        const Character &ch = cached.Metrics;
+        if (ch.Size.x > 0 && ch.Size.y > 0)
+        {
+            cached.Entry = Table.allocate();
+            Table.set(cached.Entry, ch.Size, ch.Bearing, ch.UV);
+        }
+        if (codepoint < FLAT_GLYPHS)
+            st.FlatGlyphs[codepoint] = cached;
+        else
+            st.Glyphs[codepoint] = cached;
+        storeAdvance(st, codepoint, cached.Metrics.Advance);
+    }
+
+    void eraseGlyph(Strike &st, uint32_t codepoint)
+    {
+        const CachedGlyph *cached = findGlyph(st, codepoint);
+        if (cached && cached->Metrics.Size.x > 0 && cached->Metrics.Size.y > 0)
+            Table.release(cached->Entry);
+        if (codepoint < FLAT_GLYPHS)
+            st.FlatGlyphs[codepoint].Resident = false;
+        else
+            st.Glyphs.erase(codepoint);
+    }
+
+    GLint advance(Strike &st, uint32_t codepoint)
+    {
+        if (codepoint < FLAT_GLYPHS)
+        {
+            GLint value = st.FlatAdvances[codepoint];
+            return value >= 0 ? value : loadAdvance(st, codepoint);
+        }
+        auto it = st.Advances.find(codepoint);
+        return it != st.Advances.end() ? it->second : loadAdvance(st, codepoint);
+    }
+
+    // 只加载轮廓读出步进，不光栅化
+    GLint loadAdvance(Strike &st, uint32_t codepoint)
+    {
+        GLint value = 0;
+        FT_Face face;
+        if (const BakedGlyph *baked = st.Baked ? st.Baked->find(codepoint) : nullptr)
+            value = baked->Advance;
+        else if ((face = activate(st)) && !FT_Load_Char(face, codepoint, FT_LOAD_DEFAULT))
+            value = static_cast<GLint>(face->glyph->advance.x);
+        storeAdvance(st, codepoint, value);
+        return value;
+    }
+
+    void storeAdvance(Strike &st, uint32_t codepoint, GLint value)
+    {
+        if (codepoint < FLAT_GLYPHS)
+            st.FlatAdvances[codepoint] = value;
+        else
+            st.Advances[codepoint] = value;
+    }
+
+    // 两个码位之间的字距，1/64像素
+    static GLint kerning(const Strike &st, uint32_t left, uint32_t right)
+    {
+        if (left < FLAT_GLYPHS ? !st.FlatKerns[left] : !st.OtherKerns)
+            return 0;
+        auto it = st.Kerning.find((static_cast<uint64_t>(left) << 32) | right);
+        return it != st.Kerning.end() ? it->second : 0;
+    }
+
+    // 行距和字距表每个strike只取一次：有烘焙文件就用文件里的，否则用FreeType的度量，再用FT_Get_Kerning算出Latin范围内的所有字距对
+    void prepareMetrics(Strike &st)
+    {
+        if (st.MetricsReady)
+            return;
+        st.MetricsReady = true;
+        st.LineHeight = st.PixelSize << 6;
+        if (st.Baked)
+        {
+            st.LineHeight = st.Baked->header().LineHeight;
+            st.Descender = st.Baked->header().Descender;
+            for (const BakedKerning *k = st.Baked->kerningBegin(); k != st.Baked->kerningEnd(); ++k)
+                addKerning(st, k->Left, k->Right, k->X);
+            return;
+        }
+        FT_Face face = activate(st);
+        if (!face)
+            return;
+        st.LineHeight = static_cast<GLint>(face->size->metrics.height);
+        st.Descender = static_cast<GLint>(face->size->metrics.descender);
+        if (!FT_HAS_KERNING(face))
+            return;
+        std::vector<FT_UInt> indices(FLAT_GLYPHS);
+        for (uint32_t c = 32; c < FLAT_GLYPHS; c++)
+            indices[c] = FT_Get_Char_Index(face, c);
+        for (uint32_t left = 32; left < FLAT_GLYPHS; left++)
+        {
+            if (!indices[left])
+                continue;
+            for (uint32_t right = 32; right < FLAT_GLYPHS; right++)
+            {
+                FT_Vector delta;
+                if (indices[right] && !FT_Get_Kerning(face, indices[left], indices[right], FT_KERNING_DEFAULT, &delta) && delta.x != 0)
+                    addKerning(st, left, right, static_cast<GLint>(delta.x));
+            }
+        }
+    }
+
+    static void addKerning(Strike &st, uint32_t left, uint32_t right, GLint x)
+    {
+        st.Kerning[(static_cast<uint64_t>(left) << 32) | right] = x;
+        if (left < FLAT_GLYPHS)
+            st.FlatKerns[left] = 1;
+        else
+            st.OtherKerns = true;
+    }
+
+    // 字形度量是按光栅化字号存的，把换行宽度换算成光栅化字号下的像素，0表示不自动换行
+    static GLfloat breakLimit(const Strike &st, GLfloat wrapWidth, GLfloat scale)
+    {
+        return wrapWidth > 0.0f ? wrapWidth / (scale * st.MetricScale) : 0.0f;
+    }
+
+    // 贪心断行。宽度按光栅化字号下的整像素累加，与layoutRange的步进一致；limit为0时只在'\n'处换行。
+    // 行尾的空白不计入宽度也不会引起换行；行首的空白(缩进)保留；一个单词比整行还宽时在字符之间断开
+    void computeBreaks(Strike &st, const char *begin, const char *end, GLfloat limit, std::vector<TextLine> &out)
+    {
+        const char *c = begin;
+        uint32_t lineBegin = 0;
+        GLint pen = 0;
+        uint32_t contentEnd = 0; // 这一行最后一个非空白字符之后
+        GLint contentWidth = 0;
+        // 最近一个可以断行的位置：上一个单词的结尾和当前单词的开头
+        bool canBreak = false;
+        uint32_t breakEnd = 0, wordBegin = 0;
+        GLint breakWidth = 0, wordPen = 0;
+        bool afterBlank = false;
+        uint32_t previous = 0;
+
+        while (c != end)
+        {
+            uint32_t position = static_cast<uint32_t>(c - begin);
+            uint32_t codepoint = decodeUtf8(c, end);
+            uint32_t next = static_cast<uint32_t>(c - begin);
+            if (codepoint == '\n')
+            {
+                out.push_back(TextLine{lineBegin, contentEnd, contentWidth * st.MetricScale});
+                lineBegin = contentEnd = next;
+                pen = contentWidth = 0;
+                canBreak = afterBlank = false;
+                previous = 0;
+                continue;
+            }
+
+            GLint step = (kerning(st, previous, codepoint) >> 6) + (advance(st, codepoint) >> 6);
+            previous = codepoint;
+            if (codepoint == ' ' || codepoint == '\t')
+            {
+                pen += step;
+                afterBlank = true;
+                continue;
+            }
+            if (afterBlank && contentEnd > lineBegin)
+            {
+                canBreak = true;
+                breakEnd = contentEnd;
+                breakWidth = contentWidth;
+                wordBegin = position;
+                wordPen = pen;
+            }
+            afterBlank = false;
+
+            if (limit > 0.0f && pen + step > limit && contentEnd > lineBegin)
+            {
+                if (canBreak)
+                {
+                    // 回到当前单词的开头换行，单词已经排好的部分整体挪到下一行
+                    out.push_back(TextLine{lineBegin, breakEnd, breakWidth * st.MetricScale});
+                    lineBegin = wordBegin;
+                    pen -= wordPen;
+                }
+                else
+                {
+                    // 单词比整行还宽，只能在这个字符之前断开
+                    out.push_back(TextLine{lineBegin, position, pen * st.MetricScale});
+                    lineBegin = position;
+                    pen = 0;
+                    step = advance(st, codepoint) >> 6;
+                }
+                canBreak = false;
+            }
+            pen += step;
+            contentEnd = next;
+            contentWidth = pen;
+        }
+        out.push_back(TextLine{lineBegin, contentEnd, contentWidth * st.MetricScale});
+    }
+
+    // 映射烘焙文件，把整张图集一次上传并登记所有烘焙的字形
+    void loadBaked(const std::string &path)
+    {
+        if (!Baked.open(path))
+            return;
+        const BakedFontHeader &header = Baked.header();
+        bool sdf = header.Sdf != 0;
+        int size = static_cast<int>(header.PixelSize);
+        if (sdf != (Mode == TEXT_SDF) || (sdf && header.Spread != SDF_SPREAD) || !isBucket(size) ||
+            static_cast<int>(header.AtlasWidth) > Atlas.Width || static_cast<int>(header.AtlasHeight) > Atlas.Height)
+        {
+            std::cout << "ERROR::UI_TEXT: Baked font " << path << " does not match the text mode" << std::endl;
+            Baked.close();
+            return;
+        }
+        glm::ivec2 origin;
+        if (!Atlas.addBlock(header.AtlasWidth, header.AtlasHeight, Baked.pixels(), header.AtlasWidth, origin))
+        {
+            Baked.close();
+            return;
+        }
+        Strike &st = strike(FONT_REGULAR, size);
+        st.Baked = &Baked;
+        for (const BakedGlyph *b = Baked.glyphsBegin(); b != Baked.glyphsEnd(); ++b)
+        {
+            glm::ivec4 rect(0);
+            glm::vec4 uv(0.0f);
+            if (b->Width > 0 && b->Height > 0)
+            {
+                // 与GlyphAtlas::add一致，占用的位置包括右边和下边各一个像素的间隔
+                rect = glm::ivec4(origin.x + b->X, origin.y + b->Y, b->Width + 1, b->Height + 1);
+                uv = glm::vec4(
+                    static_cast<float>(rect.x) / Atlas.Width,
+                    static_cast<float>(rect.y) / Atlas.Height,
+                    static_cast<float>(rect.x + b->Width) / Atlas.Width,
+                    static_cast<float>(rect.y + b->Height) / Atlas.Height);
+            }
+            Lru.push_front(lruKey(st, b->Codepoint));
+            storeGlyph(st, b->Codepoint, CachedGlyph{bakedCharacter(*b, uv), rect, Lru.begin(), Frame, true, 0});
+        }
+    }
+
+    bool isBucket(int size) const
+    {
+        if (Mode == TEXT_SDF)
+            return size == SDF_PIXEL_SIZE;
+        for (int bucket : SIZE_BUCKETS)
+        {
+            if (bucket == size)
+                return true;
+        }
+        return false;
+    }
+
+    static Character bakedCharacter(const BakedGlyph &b, const glm::vec4 &uv)
+    {
+        return Character{uv, glm::ivec2(b.Width, b.Height), glm::ivec2(b.Left, b.Top), static_cast<GLint>(b.Advance)};
+    }
+
+    bool insertBaked(Strike &st, const BakedGlyph &b)
+    {
+        const unsigned char *pixels = st.Baked->pixels() + static_cast<size_t>(b.Y) * st.Baked->header().AtlasWidth + b.X;
+        return insertGlyph(st, b.Codepoint, bakedCharacter(b, glm::vec4(0.0f)), pixels, st.Baked->header().AtlasWidth);
+    }
+
+    // 清空图集和所有缓存的字形(包括固定的)，之后用到时再光栅化或从烘焙文件拷贝。只能在帧末调用，
+    // 这时没有排进批次的字形；TextLayout等靠generation()知道要重新排版
+    void resetAtlas()
+    {
+        for (std::unique_ptr<Strike> &st : Strikes)
+        {
+            for (uint32_t codepoint = 0; codepoint < FLAT_GLYPHS; codepoint++)
+            {
+                if (st->FlatGlyphs[codepoint].Resident)
+                    eraseGlyph(*st, codepoint);
+            }
+            for (auto &cached : st->Glyphs)
+            {
+                if (cached.second.Metrics.Size.x > 0 && cached.second.Metrics.Size.y > 0)
+                    Table.release(cached.second.Entry);
+            }
+            st->Glyphs.clear();
+        }
+        Lru.clear();
+        Atlas.clear();
+        RepackPending = false;
+    }
+
+    // 把光栅化好的位图放进图集并加入缓存，图集满了就从最久没用的字形开始淘汰(不分字体和字号)，
+    // 但不能淘汰这一帧已经排进批次的字形和固定的字形
+    bool insertGlyph(Strike &st, uint32_t codepoint, Character character, const unsigned char *pixels, int pitch)
+    {
+        glm::ivec4 rect;
+        while (!Atlas.add(character.Size.x, character.Size.y, pixels, pitch, rect, character.UV))
+        {
+            CachedGlyph *victim = nullptr;
+            Strike *owner = nullptr;
+            uint32_t victimCodepoint = 0;
+            if (!Lru.empty())
+            {
+                owner = Strikes[Lru.back() >> 32].get();
+                victimCodepoint = static_cast<uint32_t>(Lru.back());
+                victim = findGlyph(*owner, victimCodepoint);
+            }
+            if (!victim || victim->LastUsed == Frame)
+            {
+                // 能淘汰的都淘汰了。空闲的总面积够却放不下，说明被这一帧用到的字形切碎了：这一帧先缺这个字，
+                // 帧末flush()清空图集，之后用到的字形重新放置
+                if (Atlas.freeArea() >= GlyphAtlas::slotArea(character.Size.x, character.Size.y))
+                {
+                    if (!RepackPending)
+                        std::cout << "ERROR::UI_TEXT: Glyph atlas is fragmented, repacking at the end of the frame" << std::endl;
+                    RepackPending = true;
+                }
+                else
+                    std::cout << "ERROR::UI_TEXT: Glyph atlas is full" << std::endl;
+                return false;
+            }
+            if (Pins.count(Lru.back()))
+            {
+                // 固定的字形当作这一帧用过，挪到最前面，每帧最多挪一次
+                victim->LastUsed = Frame;
+                Lru.splice(Lru.begin(), Lru, victim->LruEntry);
+                continue;
+            }
+            Atlas.release(victim->Slot);
+            eraseGlyph(*owner, victimCodepoint);
+            Lru.pop_back();
+            Evictions++;
+        }
+
+        Lru.push_front(lruKey(st, codepoint));
+        storeGlyph(st, codepoint, CachedGlyph{character, rect, Lru.begin(), Frame, true, 0});
+        return true;
+    }
 };
-#endif
\ No newline at end of file
+
+constexpr int UiText::SIZE_BUCKETS[];
+#endif
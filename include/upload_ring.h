@@ -0,0 +1,100 @@
+#ifndef UPLOAD_RING_H
+#define UPLOAD_RING_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <vector>
+
+// Ring of pixel unpack buffers for texture uploads. Pixels are written into a mapped slot and the
+// glTex(Sub)Image calls that follow source from the bound buffer, so the driver copies on the GPU
+// timeline instead of synchronously out of client memory. A fence placed after those calls tells
+// when the slot may be written again; map() never waits for a slot unless asked to.
+class UploadRing
+{
+public:
+    explicit UploadRing(size_t slots = 4) : Slots(slots), Next(0), Mapped(-1)
+    {
+        for (Slot &slot : Slots)
+        {
+            glGenBuffers(1, &slot.Buffer);
+            slot.Capacity = 0;
+            slot.Fence = 0;
+        }
+    }
+
+    ~UploadRing()
+    {
+        for (Slot &slot : Slots)
+        {
+            if (slot.Fence)
+                glDeleteSync(slot.Fence);
+            glDeleteBuffers(1, &slot.Buffer);
+        }
+    }
+
+    UploadRing(const UploadRing &) = delete;
+    UploadRing &operator=(const UploadRing &) = delete;
+
+    // map the next slot for size bytes and leave it bound to GL_PIXEL_UNPACK_BUFFER.
+    // returns nullptr when the GPU is still reading that slot, unless wait is set
+    unsigned char *map(size_t size, bool wait = false)
+    {
+        Slot &slot = Slots[Next];
+        if (slot.Fence)
+        {
+            GLenum status = glClientWaitSync(slot.Fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? WAIT_TIMEOUT : 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                return nullptr;
+            glDeleteSync(slot.Fence);
+            slot.Fence = 0;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.Buffer);
+        if (size > slot.Capacity)
+        {
+            slot.Capacity = size;
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+        }
+        // the fence has passed, nothing reads the slot any more
+        void *pixels = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (!pixels)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return nullptr;
+        }
+        Mapped = static_cast<int>(Next);
+        return static_cast<unsigned char *>(pixels);
+    }
+
+    // finish writing; the slot stays bound so pixel pointers passed to GL are offsets into it
+    void unmap()
+    {
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+
+    // fence the slot after the calls that read from it and move on to the next one
+    void submit()
+    {
+        if (Mapped < 0)
+            return;
+        Slots[Mapped].Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        Next = (Next + 1) % Slots.size();
+        Mapped = -1;
+    }
+
+private:
+    struct Slot
+    {
+        GLuint Buffer;
+        size_t Capacity;
+        GLsync Fence; // 0 once the GPU is done with the slot
+    };
+
+    static const GLuint64 WAIT_TIMEOUT = 1000000000; // 1 s in ns
+
+    std::vector<Slot> Slots;
+    size_t Next;
+    int Mapped;
+};
+#endif
@@ -0,0 +1,68 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <cstdint>
+
+const uint32_t UTF8_REPLACEMENT_CHARACTER = 0xFFFD;
+
+// decode one codepoint starting at p and advance p past it. Malformed, overlong or truncated
+// sequences yield U+FFFD and consume a single byte so decoding always makes progress
+inline uint32_t decodeUtf8(const char *&p, const char *end)
+{
+    const unsigned char *s = reinterpret_cast<const unsigned char *>(p);
+    unsigned char lead = s[0];
+    if (lead < 0x80)
+    {
+        p++;
+        return lead;
+    }
+
+    int length;
+    uint32_t codepoint, minimum;
+    if ((lead & 0xE0) == 0xC0)
+    {
+        length = 2;
+        codepoint = lead & 0x1F;
+        minimum = 0x80;
+    }
+    else if ((lead & 0xF0) == 0xE0)
+    {
+        length = 3;
+        codepoint = lead & 0x0F;
+        minimum = 0x800;
+    }
+    else if ((lead & 0xF8) == 0xF0)
+    {
+        length = 4;
+        codepoint = lead & 0x07;
+        minimum = 0x10000;
+    }
+    else
+    {
+        p++;
+        return UTF8_REPLACEMENT_CHARACTER;
+    }
+
+    if (end - p < length)
+    {
+        p++;
+        return UTF8_REPLACEMENT_CHARACTER;
+    }
+    for (int i = 1; i < length; i++)
+    {
+        if ((s[i] & 0xC0) != 0x80)
+        {
+            p++;
+            return UTF8_REPLACEMENT_CHARACTER;
+        }
+        codepoint = (codepoint << 6) | (s[i] & 0x3F);
+    }
+    if (codepoint < minimum || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+    {
+        p++;
+        return UTF8_REPLACEMENT_CHARACTER;
+    }
+    p += length;
+    return codepoint;
+}
+#endif
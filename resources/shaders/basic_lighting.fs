@@ -5,8 +5,16 @@ in vec3 Normal;
 in vec3 FragPos;  
 in vec2 TexCoords;
   
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    mat4 viewProj;
+    vec3 cameraPos;
+    float time;
+};
+
 uniform vec3 lightPos; 
-uniform vec3 viewPos; 
 uniform vec3 lightColor;
 uniform vec3 objectColor;
 
@@ -28,7 +36,7 @@ void main()
     
     // specular
     float specularStrength = 0.5;
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(cameraPos - FragPos);
     vec3 reflectDir = reflect(-lightDir, norm);  
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
     vec3 specular = specularStrength * spec * lightColor * texture(specularMap, TexCoords).rgb;  
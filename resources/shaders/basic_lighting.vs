@@ -7,9 +7,16 @@ out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
 
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    mat4 viewProj;
+    vec3 cameraPos;
+    float time;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
@@ -17,5 +24,5 @@ void main()
     Normal = mat3(transpose(inverse(model))) * aNormal;  
     TexCoords = aTexCoords;
     
-    gl_Position = projection * view * vec4(FragPos, 1.0);
+    gl_Position = viewProj * vec4(FragPos, 1.0);
 }
\ No newline at end of file
@@ -3,12 +3,19 @@ layout (location = 0) in vec3 aPos; // <vec3 pos>
 layout (location = 1) in vec2 tex; // <vec2 tex>
 out vec2 TexCoords;
 
-uniform mat4 projection;
-uniform mat4 view;
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    mat4 viewProj;
+    vec3 cameraPos;
+    float time;
+};
+
 uniform mat4 model;
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(aPos, 1.0);
+	gl_Position = viewProj * model * vec4(aPos, 1.0);
     TexCoords = tex;
 }
\ No newline at end of file
@@ -0,0 +1,16 @@
+#version 330 core
+in vec2 TexCoords;
+in vec4 Color;
+out vec4 color;
+
+uniform sampler2D text;
+
+void main()
+{
+    // FreeType SDF glyphs: 0.5 on the outline, larger inside. The atlas is swizzled to (1, 1, 1, distance)
+    float dist = texture(text, TexCoords).a;
+    // antialias over one screen pixel whatever the text size
+    float width = fwidth(dist);
+    float alpha = smoothstep(0.5 - width, 0.5 + width, dist);
+    color = vec4(Color.rgb, Color.a * alpha);
+}
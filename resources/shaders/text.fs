@@ -0,0 +1,12 @@
+#version 330 core
+in vec2 TexCoords;
+in vec4 Color;
+out vec4 color;
+
+uniform sampler2D text;
+
+void main()
+{
+    // the glyph atlas is swizzled to (1, 1, 1, coverage)
+    color = Color * texture(text, TexCoords);
+}
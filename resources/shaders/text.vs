@@ -0,0 +1,24 @@
+#version 330 core
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aTexCoords;
+layout (location = 2) in vec4 aColor;
+out vec2 TexCoords;
+out vec4 Color;
+
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    mat4 viewProj;
+    vec3 cameraPos;
+    float time;
+};
+
+uniform mat4 model;
+
+void main()
+{
+    gl_Position = viewProj * model * vec4(aPos, 0.0, 1.0);
+    TexCoords = aTexCoords;
+    Color = aColor;
+}
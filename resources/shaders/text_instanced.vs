@@ -0,0 +1,32 @@
+#version 330 core
+layout (location = 0) in vec3 aPen; // <vec2 pen, float scale>
+layout (location = 1) in uint aGlyph;
+layout (location = 2) in vec4 aColor;
+out vec2 TexCoords;
+out vec4 Color;
+
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    mat4 view;
+    mat4 viewProj;
+    vec3 cameraPos;
+    float time;
+};
+
+uniform mat4 model;
+// two texels per glyph: (left, bottom, width, height) in raster pixels, then (u0, v0, u1, v1)
+uniform samplerBuffer glyphs;
+
+void main()
+{
+    vec4 box = texelFetch(glyphs, int(aGlyph) * 2);
+    vec4 uv = texelFetch(glyphs, int(aGlyph) * 2 + 1);
+    // triangle strip corners (0, 0) (1, 0) (0, 1) (1, 1), counter clockwise like the batched quads
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    vec2 pos = aPen.xy + (box.xy + corner * box.zw) * aPen.z;
+    gl_Position = viewProj * model * vec4(pos, 0.0, 1.0);
+    // v0 is the top row of the glyph
+    TexCoords = vec2(mix(uv.x, uv.z, corner.x), mix(uv.w, uv.y, corner.y));
+    Color = aColor;
+}
@@ -10,12 +10,17 @@
 #include FT_FREETYPE_H
 
 #include <shader.h>
+#include <frame_data.h>
+#include <gl_state.h>
 #include <camera.h>
 #include <node.h>
 #include <cube_render.h>
 #include <ui_text.h>
+#include <text_layout.h>
 #include <texture_render.h>
+#include <texture_manager.h>
 
+#include <cstdio>
 #include <iostream>
 #include <map>
 
@@ -23,7 +28,6 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 void mouse_callback(GLFWwindow *window, double xpos, double ypos);
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
-unsigned int loadTexture(const char *path);
 
 // settings
 const unsigned int SCR_WIDTH = 1920;
@@ -78,48 +82,69 @@ int main()
 
     // configure global opengl state
     // -----------------------------
-    glEnable(GL_DEPTH_TEST);
+    GLState::get().setDepthTest(true);
 
     // Compile and setup the shader
 
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_BLEND);
+    GLState::get().setCullFace(true);
+    GLState::get().setBlend(true);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     Shader sdfShader("resources/shaders/sdf.vs", "resources/shaders/sdf.fs");
 
     Shader uiTextShader("resources/shaders/font.vs", "resources/shaders/font.fs");
-    glm::mat4 projection = glm::ortho(0.0f, static_cast<GLfloat>(SCR_WIDTH), 0.0f, static_cast<GLfloat>(SCR_HEIGHT));
-    glm::mat4 model = glm::mat4(1.0f);
-    glm::mat4 view = glm::mat4(1.0f);
-    uiTextShader.use();
-    uiTextShader.setMat4("projection", projection);
-    uiTextShader.setMat4("model", model);
-    uiTextShader.setMat4("view", view);
-
-    UiText uiText;
+    Shader sdfTextShader("resources/shaders/text.vs", "resources/shaders/sdf_text.fs");
+    // text rebuilt every frame (the frame time counter) expands its quads on the GPU
+    Shader dynamicTextShader("resources/shaders/text_instanced.vs", "resources/shaders/sdf_text.fs");
+
+    // per-frame camera data shared by every program through the FrameData uniform block
+    FrameUniforms frameUniforms;
+    glm::mat4 screenProjection = glm::ortho(0.0f, static_cast<GLfloat>(SCR_WIDTH), 0.0f, static_cast<GLfloat>(SCR_HEIGHT));
+
+    // distance field glyphs stay sharp at any scale from one small atlas
+    // the atlas is baked at build time (FontBaker), glyphs outside the baked set fall back to FreeType
+    UiText uiText(TEXT_SDF, "resources/fonts/arial_sdf.bfnt");
+    // without a baked file, rasterize printable ASCII up front on all cores so the first frames don't stall on FreeType
+    std::vector<uint32_t> ascii;
+    for (uint32_t c = 32; c < 127; c++)
+        ascii.push_back(c);
+    uiText.preload(ascii);
     TextureRender textureRender;
 
+    // the HUD strings never change, lay them out once and keep the quads on the GPU
+    TextLayout sampleText, copyrightText;
+    sampleText.set("This is sample te啊xt", 25.0f, 25.0f, 1.0f, glm::vec3(0.5, 0.8f, 0.2f));
+    copyrightText.set("(C) LearnOpenGL.com", 125.0f, 125.0f, 0.5f, glm::vec3(0.3, 0.7f, 0.9f), 100.0f, TEXT_ALIGN_LEFT, FONT_ITALIC);
+
     // build and compile our shader zprogram
     // ------------------------------------
     Shader basicLighting("resources/shaders/basic_lighting.vs", "resources/shaders/basic_lighting.fs");
     Shader lightCubeShader("resources/shaders/light_cube.vs", "resources/shaders/light_cube.fs");
 
     // load textures (we now use a utility function to keep the code more organized)
+    // the .btex files are baked at build time (TextureBaker) with their mip chains and only need mapping;
+    // the textures show a placeholder until pump() uploads them. The manager shares textures loaded
+    // twice and keeps the total under its memory budget, so bind handle.get() every frame
     // -----------------------------------------------------------------------------
-    unsigned int diffuseMap = loadTexture("resources/textures/container2.png");
-    unsigned int specularMap = loadTexture("resources/textures/container2_specular.png");
-    unsigned int meguminn = loadTexture("resources/textures/meguminnnnn.png");
-    unsigned int sdfOrigin = loadTexture("resources/textures/tu.png");
-    unsigned int sdf64 = loadTexture("resources/textures/tu-sdf64.png");
-    unsigned int sdf128 = loadTexture("resources/textures/tu-sdf128.png");
-    unsigned int sdf512 = loadTexture("resources/textures/tu-sdf512.png");
+    TextureManager textureManager;
+    TextureHandle diffuseMap = textureManager.acquire("resources/textures/container2.btex");
+    TextureHandle specularMap = textureManager.acquire("resources/textures/container2_specular.btex");
+    TextureHandle meguminn = textureManager.acquire("resources/textures/meguminnnnn.btex");
+    TextureHandle sdfOrigin = textureManager.acquire("resources/textures/tu.btex");
+    TextureHandle sdf64 = textureManager.acquire("resources/textures/tu-sdf64.btex");
+    TextureHandle sdf128 = textureManager.acquire("resources/textures/tu-sdf128.btex");
+    TextureHandle sdf512 = textureManager.acquire("resources/textures/tu-sdf512.btex");
 
     // shader configuration
     // --------------------
     basicLighting.use();
-    basicLighting.setInt("diffuseMap", 0);
-    basicLighting.setInt("specularMap", 1);
+    basicLighting.setInt("diffuseMap"_u, 0);
+    basicLighting.setInt("specularMap"_u, 1);
+
+    // resolve the uniforms set every frame once, the render loop only uses the handles
+    UniformHandle objectColorUniform = basicLighting.uniform("objectColor"_u);
+    UniformHandle lightColorUniform = basicLighting.uniform("lightColor"_u);
+    UniformHandle lightPosUniform = basicLighting.uniform("lightPos"_u);
 
     CubeRender cubeRender;
 
@@ -144,73 +169,79 @@ int main()
         // -----
         processInput(window);
 
+        // evict over-budget textures, then upload the ones that finished decoding since the last frame
+        textureManager.pump();
+
         // render
         // ------
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        // view/projection transformations, uploaded once for all programs
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+        frameUniforms.update(
+            FrameUniforms::make(projection, view, camera.Position, currentFrame),
+            FrameUniforms::make(screenProjection, glm::mat4(1.0f), camera.Position, currentFrame));
+        frameUniforms.bind(FrameUniforms::SCENE);
+
         // be sure to activate shader when setting uniforms/drawing objects
         basicLighting.use();
-        basicLighting.setVec3("objectColor", 1.0f, 0.5f, 0.31f);
-        basicLighting.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
-        basicLighting.setVec3("lightPos", lightNode.position.x, lightNode.position.y, lightNode.position.z);
-        basicLighting.setVec3("viewPos", camera.Position);
+        basicLighting.setVec3(objectColorUniform, 1.0f, 0.5f, 0.31f);
+        basicLighting.setVec3(lightColorUniform, 1.0f, 1.0f, 1.0f);
+        basicLighting.setVec3(lightPosUniform, lightNode.position.x, lightNode.position.y, lightNode.position.z);
 
-        // view/projection transformations
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        basicLighting.setMat4("projection", projection);
-        basicLighting.setMat4("view", view);
         // bind diffuse map
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuseMap);
+        GLState::get().bindTexture(0, GL_TEXTURE_2D, diffuseMap.get());
         // bind specular map
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, specularMap);
+        GLState::get().bindTexture(1, GL_TEXTURE_2D, specularMap.get());
 
         // world transformation
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model, cubeNode.position);
         model = glm::scale(model, glm::vec3(cubeNode.scale));
-        cubeRender.draw(basicLighting, model, view, projection);
+        cubeRender.draw(basicLighting, model);
 
         // also draw the lamp object
         lightCubeShader.use();
         model = glm::mat4(1.0f);
         model = glm::translate(model, lightNode.position);
         model = glm::scale(model, glm::vec3(lightNode.scale)); // a smaller cube
-        cubeRender.draw(lightCubeShader, model, view, projection);
+        cubeRender.draw(lightCubeShader, model);
 
-        uiText.drawText(uiTextShader, "This is sample te啊xt", 25.0f, 25.0f, 1.0f, glm::vec3(0.5, 0.8f, 0.2f));
-        uiText.drawTextResizeHeight(uiTextShader, "(C) LearnOpenGL.com", 125.0f, 125.0f, 0.5f, glm::vec3(0.3, 0.7f, 0.9f));
+        frameUniforms.bind(FrameUniforms::SCREEN);
+        sampleText.draw(uiText, sdfTextShader);
+        copyrightText.draw(uiText, sdfTextShader);
+        char frameTime[32];
+        std::snprintf(frameTime, sizeof(frameTime), "%.2f ms", deltaTime * 1000.0f);
+        uiText.drawDynamicText(dynamicTextShader, frameTime, 25.0f, SCR_HEIGHT - 40.0f, 0.5f, glm::vec3(1.0f));
+        uiText.flush();
 
-        // model = glm::mat4(1.0f);
-        // view = glm::mat4(1.0f);
-        // projection = glm::ortho(0.0f, static_cast<GLfloat>(SCR_WIDTH), 0.0f, static_cast<GLfloat>(SCR_HEIGHT));
+        frameUniforms.bind(FrameUniforms::SCENE);
         textureRender.draw(
             uiTextShader,
-            sdfOrigin,
+            sdfOrigin.get(),
             0.0, 0.0,
             20.0, 20.0,
-            model, view, projection);
+            model);
         textureRender.draw(
             sdfShader,
-            sdf64,
+            sdf64.get(),
             20.0, 0.0,
             20.0, 20.0,
-            model, view, projection);
+            model);
         textureRender.draw(
             sdfShader,
-            sdf128,
+            sdf128.get(),
             40.0, 0.0,
             20.0, 20.0,
-            model, view, projection);
+            model);
         textureRender.draw(
             sdfShader,
-            sdf512,
+            sdf512.get(),
             60.0, 0.0,
             20.0, 20.0,
-            model, view, projection);
+            model);
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
         glfwSwapBuffers(window);
@@ -223,6 +254,9 @@ int main()
     // glDeleteVertexArrays(1, &lightCubeVAO);
     // glDeleteBuffers(1, &VBO);
 
+    const GLState::Stats &glStats = GLState::get().stats();
+    std::cout << "GL state calls issued: " << glStats.Issued << ", skipped as redundant: " << glStats.Skipped << std::endl;
+
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
     glfwTerminate();
@@ -285,42 +319,3 @@ void scroll_callback(GLFWwindow *window, double xoffset, double yoffset)
 {
     camera.ProcessMouseScroll(yoffset);
 }
-
-// utility function for loading a 2D texture from file
-// ---------------------------------------------------
-unsigned int loadTexture(char const *path)
-{
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D); //多级渐远纹理
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
@@ -1,2 +1,8 @@
+// stb_image allocates through ImageLoader so it can decode straight into a caller's buffer
+#include "image_loader.h"
+
+#define STBI_MALLOC(size) ImageLoader::allocate(size)
+#define STBI_REALLOC(pointer, size) ImageLoader::reallocate(pointer, size)
+#define STBI_FREE(pointer) ImageLoader::release(pointer)
 #define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
\ No newline at end of file
+#include "stb_image.h"
@@ -0,0 +1,243 @@
+// Bakes a font into a file UiText can map at startup instead of running FreeType:
+// glyph metrics, kerning pairs and a packed R8 atlas, see include/baked_font.h for the layout.
+//
+// usage: FontBaker <font.ttf> <output> [--sdf] [--size N] [--spread N] [--width N]
+//                  [--chars RANGES] [--text FILE] [--threads N]
+//   --sdf      signed distance field glyphs for TEXT_SDF, otherwise coverage bitmaps for TEXT_BITMAP
+//   --size     pixel size, defaults to what UiText rasterizes at (48, or 32 with --sdf)
+//   --width    atlas width, must match the runtime atlas (1024, or 512 with --sdf)
+//   --chars    comma separated codepoints or ranges, e.g. 32-126,0x4E00-0x4E2F (default 32-126)
+//   --text     additionally bake every codepoint used in a UTF-8 text file
+#include <baked_font.h>
+#include <glyph_rasterizer.h>
+#include <rect_packer.h>
+#include <utf8.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// kerning is looked up for every pair, so only scripts that actually kern are considered
+const uint32_t KERNING_LIMIT = 0x2000;
+
+static bool parseRanges(const std::string &text, std::set<uint32_t> &out)
+{
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        if (item.empty())
+            continue;
+        size_t dash = item.find('-', 1);
+        char *end;
+        unsigned long first = std::strtoul(item.c_str(), &end, 0);
+        unsigned long last = first;
+        if (dash != std::string::npos)
+            last = std::strtoul(item.c_str() + dash + 1, &end, 0);
+        if (*end != '\0' || last < first || last > 0x10FFFF)
+        {
+            std::cout << "ERROR::FONT_BAKER: Bad codepoint range " << item << std::endl;
+            return false;
+        }
+        for (unsigned long c = first; c <= last; c++)
+            out.insert(static_cast<uint32_t>(c));
+    }
+    return true;
+}
+
+static bool readText(const std::string &path, std::set<uint32_t> &out)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "ERROR::FONT_BAKER: Could not read " << path << std::endl;
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const char *c = text.data(), *end = text.data() + text.size();
+    while (c != end)
+    {
+        uint32_t codepoint = decodeUtf8(c, end);
+        if (codepoint >= 32)
+            out.insert(codepoint);
+    }
+    return true;
+}
+
+static uint64_t align8(uint64_t offset)
+{
+    return (offset + 7) & ~uint64_t(7);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cout << "usage: FontBaker <font.ttf> <output> [--sdf] [--size N] [--spread N] [--width N] [--chars RANGES] [--text FILE] [--threads N]" << std::endl;
+        return 1;
+    }
+    RasterizerOptions options{argv[1], 0, false, 6};
+    std::string output = argv[2];
+    int width = 0;
+    unsigned int threads = 0;
+    std::set<uint32_t> codepoints;
+    bool charsGiven = false;
+    for (int i = 3; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--sdf")
+            options.Sdf = true;
+        else if (arg == "--size" && hasValue)
+            options.PixelSize = std::atoi(argv[++i]);
+        else if (arg == "--spread" && hasValue)
+            options.Spread = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (arg == "--width" && hasValue)
+            width = std::atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue)
+            threads = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else if (arg == "--chars" && hasValue)
+        {
+            charsGiven = true;
+            if (!parseRanges(argv[++i], codepoints))
+                return 1;
+        }
+        else if (arg == "--text" && hasValue)
+        {
+            charsGiven = true;
+            if (!readText(argv[++i], codepoints))
+                return 1;
+        }
+        else
+        {
+            std::cout << "ERROR::FONT_BAKER: Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (options.PixelSize <= 0)
+        options.PixelSize = options.Sdf ? 32 : 48;
+    if (width <= 0)
+        width = options.Sdf ? 512 : 1024;
+    if (!charsGiven)
+        parseRanges("32-126", codepoints);
+
+    // font wide metrics and the glyph indices needed for kerning
+    FT_Library ft;
+    FT_Face face;
+    if (!GlyphRasterizer::open(options, ft, face))
+        return 1;
+    std::vector<uint32_t> wanted;
+    for (uint32_t codepoint : codepoints)
+    {
+        if (FT_Get_Char_Index(face, codepoint) != 0)
+            wanted.push_back(codepoint);
+    }
+
+    std::vector<RasterizedGlyph> glyphs = GlyphRasterizer::rasterize(options, wanted, threads);
+    glyphs.erase(std::remove_if(glyphs.begin(), glyphs.end(), [](const RasterizedGlyph &g) { return !g.Loaded; }), glyphs.end());
+
+    // pack tallest first, that keeps the skyline flat
+    std::vector<size_t> order(glyphs.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return glyphs[a].Height > glyphs[b].Height; });
+
+    const int maxHeight = 16384;
+    RectPacker packer(width, maxHeight);
+    std::vector<BakedGlyph> records(glyphs.size());
+    int atlasHeight = 0;
+    for (size_t i : order)
+    {
+        const RasterizedGlyph &g = glyphs[i];
+        glm::ivec2 position(0);
+        if (g.Width > 0 && g.Height > 0)
+        {
+            // same padding as GlyphAtlas so evicted slots can be reused at runtime
+            if (!packer.pack(g.Width + 1, g.Height + 1, position))
+            {
+                std::cout << "ERROR::FONT_BAKER: Glyphs do not fit into a " << width << " texel wide atlas" << std::endl;
+                return 1;
+            }
+            atlasHeight = std::max(atlasHeight, position.y + g.Height + 1);
+        }
+        records[i] = BakedGlyph{g.Codepoint,
+                                static_cast<uint16_t>(position.x), static_cast<uint16_t>(position.y),
+                                static_cast<uint16_t>(g.Width), static_cast<uint16_t>(g.Height),
+                                static_cast<int16_t>(g.Left), static_cast<int16_t>(g.Top),
+                                static_cast<int32_t>(g.Advance)};
+    }
+
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * atlasHeight, 0);
+    for (size_t i = 0; i < glyphs.size(); i++)
+    {
+        const RasterizedGlyph &g = glyphs[i];
+        for (int row = 0; row < g.Height; row++)
+            std::memcpy(&pixels[static_cast<size_t>(records[i].Y + row) * width + records[i].X], &g.Pixels[static_cast<size_t>(row) * g.Width], g.Width);
+    }
+    std::sort(records.begin(), records.end(), [](const BakedGlyph &a, const BakedGlyph &b) { return a.Codepoint < b.Codepoint; });
+
+    std::vector<BakedKerning> kerning;
+    if (FT_HAS_KERNING(face))
+    {
+        for (const BakedGlyph &left : records)
+        {
+            if (left.Codepoint >= KERNING_LIMIT)
+                break;
+            FT_UInt leftIndex = FT_Get_Char_Index(face, left.Codepoint);
+            for (const BakedGlyph &right : records)
+            {
+                if (right.Codepoint >= KERNING_LIMIT)
+                    break;
+                FT_Vector delta;
+                if (!FT_Get_Kerning(face, leftIndex, FT_Get_Char_Index(face, right.Codepoint), FT_KERNING_DEFAULT, &delta) && delta.x != 0)
+                    kerning.push_back(BakedKerning{left.Codepoint, right.Codepoint, static_cast<int32_t>(delta.x)});
+            }
+        }
+    }
+
+    BakedFontHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.Magic, "BFNT", 4);
+    header.Version = BAKED_FONT_VERSION;
+    header.PixelSize = static_cast<uint32_t>(options.PixelSize);
+    header.Sdf = options.Sdf ? 1 : 0;
+    header.Spread = options.Sdf ? options.Spread : 0;
+    header.Ascender = static_cast<int32_t>(face->size->metrics.ascender);
+    header.Descender = static_cast<int32_t>(face->size->metrics.descender);
+    header.LineHeight = static_cast<int32_t>(face->size->metrics.height);
+    header.GlyphCount = static_cast<uint32_t>(records.size());
+    header.KerningCount = static_cast<uint32_t>(kerning.size());
+    header.AtlasWidth = static_cast<uint32_t>(width);
+    header.AtlasHeight = static_cast<uint32_t>(atlasHeight);
+    header.GlyphOffset = align8(sizeof(header));
+    header.KerningOffset = align8(header.GlyphOffset + records.size() * sizeof(BakedGlyph));
+    header.PixelOffset = align8(header.KerningOffset + kerning.size() * sizeof(BakedKerning));
+    FT_Done_Face(face);
+    FT_Done_FreeType(ft);
+
+    std::vector<unsigned char> file(header.PixelOffset + pixels.size(), 0);
+    std::memcpy(&file[0], &header, sizeof(header));
+    if (!records.empty())
+        std::memcpy(&file[header.GlyphOffset], records.data(), records.size() * sizeof(BakedGlyph));
+    if (!kerning.empty())
+        std::memcpy(&file[header.KerningOffset], kerning.data(), kerning.size() * sizeof(BakedKerning));
+    if (!pixels.empty())
+        std::memcpy(&file[header.PixelOffset], pixels.data(), pixels.size());
+
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(file.data()), file.size());
+    if (!out)
+    {
+        std::cout << "ERROR::FONT_BAKER: Could not write " << output << std::endl;
+        return 1;
+    }
+    std::printf("%s: %zu glyphs, %zu kerning pairs, %dx%d atlas, %zu bytes\n", output.c_str(), records.size(), kerning.size(), width, atlasHeight, file.size());
+    return 0;
+}
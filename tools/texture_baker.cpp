@@ -0,0 +1,117 @@
+// Converts an image into a texture file TextureLoader can map and upload level by level instead of
+// inflating a PNG and running glGenerateMipmap at startup, see include/baked_texture.h for the layout.
+//
+// usage: TextureBaker <image> <output> [--filter box|kaiser|lanczos] [--srgb] [--coverage CUTOFF] [--threads N]
+//   --filter    mip filter, box (default) matches what glGenerateMipmap produced before
+//   --srgb      filter color in linear light and store GL_SRGB8(_ALPHA8)
+//   --coverage  keep the share of texels with alpha above CUTOFF (0-1) constant down the chain
+//   --threads   threads per level, default all cores
+#include <baked_texture.h>
+#include <mip_generator.h>
+#include <stb_image.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static uint64_t align8(uint64_t offset)
+{
+    return (offset + 7) & ~uint64_t(7);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cout << "usage: TextureBaker <image> <output> [--filter box|kaiser|lanczos] [--srgb] [--coverage CUTOFF] [--threads N]" << std::endl;
+        return 1;
+    }
+    std::string input = argv[1], output = argv[2];
+    MipOptions options;
+    options.Threads = 0;
+    for (int i = 3; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue)
+        {
+            std::string filter = argv[++i];
+            if (filter == "box")
+                options.Filter = MIP_BOX;
+            else if (filter == "kaiser")
+                options.Filter = MIP_KAISER;
+            else if (filter == "lanczos")
+                options.Filter = MIP_LANCZOS;
+            else
+            {
+                std::cout << "ERROR::TEXTURE_BAKER: Unknown filter " << filter << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--srgb")
+            options.Srgb = true;
+        else if (arg == "--coverage" && hasValue)
+            options.AlphaCutoff = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--threads" && hasValue)
+            options.Threads = static_cast<unsigned int>(std::atoi(argv[++i]));
+        else
+        {
+            std::cout << "ERROR::TEXTURE_BAKER: Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    int width, height, components;
+    unsigned char *pixels = stbi_load(input.c_str(), &width, &height, &components, 0);
+    if (!pixels)
+    {
+        std::cout << "ERROR::TEXTURE_BAKER: Could not load " << input << std::endl;
+        return 1;
+    }
+    MipChain mips = MipGenerator::chain(pixels, width, height, components, options);
+    stbi_image_free(pixels);
+
+    // same formats TextureLoader picks for a decoded image
+    const GLenum formats[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+    const GLenum internalFormats[] = {GL_R8, GL_RG8, GL_RGB8, GL_RGBA8};
+    const GLenum srgbFormats[] = {GL_R8, GL_RG8, GL_SRGB8, GL_SRGB8_ALPHA8};
+
+    BakedTextureHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.Magic, "BTEX", 4);
+    header.Version = BAKED_TEXTURE_VERSION;
+    header.Width = static_cast<uint32_t>(width);
+    header.Height = static_cast<uint32_t>(height);
+    header.Components = static_cast<uint32_t>(components);
+    header.InternalFormat = options.Srgb ? srgbFormats[components - 1] : internalFormats[components - 1];
+    header.Format = formats[components - 1];
+    header.Levels = static_cast<uint32_t>(mips.Levels.size());
+
+    // the chain is already back to back, so the loader can copy it in one go
+    std::vector<BakedTextureLevel> table(mips.Levels.size());
+    uint64_t base = align8(sizeof(header) + table.size() * sizeof(BakedTextureLevel));
+    for (size_t i = 0; i < mips.Levels.size(); i++)
+    {
+        const MipLevel &level = mips.Levels[i];
+        table[i] = BakedTextureLevel{static_cast<uint32_t>(level.Width), static_cast<uint32_t>(level.Height), base + level.Offset, level.Size};
+    }
+
+    std::vector<unsigned char> file(base + mips.Data.size(), 0);
+    std::memcpy(&file[0], &header, sizeof(header));
+    std::memcpy(&file[sizeof(header)], table.data(), table.size() * sizeof(BakedTextureLevel));
+    std::memcpy(&file[base], mips.Data.data(), mips.Data.size());
+
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(file.data()), file.size());
+    if (!out)
+    {
+        std::cout << "ERROR::TEXTURE_BAKER: Could not write " << output << std::endl;
+        return 1;
+    }
+    std::printf("%s: %dx%d, %d components, %zu levels, %zu bytes\n", output.c_str(), width, height, components, mips.Levels.size(), file.size());
+    return 0;
+}